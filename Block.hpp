@@ -1,4 +1,5 @@
 #pragma once
+#include <algorithm>
 
 enum BlockType {
     BLOCK_AIR, 
@@ -10,9 +11,42 @@ enum BlockType {
     SAND_BLOCK,
     GLASS_BLOCK,
     OAK_PLANKS,
-    STONE_BRICKS
+    STONE_BRICKS,
+    WATER_BLOCK,     // 水源
+    WATER_FLOW_1,    // 流动的水, 数字为水位 (1 最低, 7 最高)
+    WATER_FLOW_2,
+    WATER_FLOW_3,
+    WATER_FLOW_4,
+    WATER_FLOW_5,
+    WATER_FLOW_6,
+    WATER_FLOW_7,
+    GLOWSTONE,       // 发光方块
+    BLOCK_TYPE_COUNT // 方块种类数, 新方块加在它之前
 };
 
+const int WATER_SOURCE_LEVEL = 8; // 水源的水位, 高于所有流动的水
+
+// 水位: 水源为 WATER_SOURCE_LEVEL, 流动的水为 1..7, 其他方块为 0
+int waterLevel(BlockType type) {
+    if (type == WATER_BLOCK) return WATER_SOURCE_LEVEL;
+    if (type >= WATER_FLOW_1 && type <= WATER_FLOW_7) return type - WATER_FLOW_1 + 1;
+    return 0;
+}
+
+// 水位为 level (1..7) 的流动的水, level <= 0 时为空气
+BlockType flowingWater(int level) {
+    return level <= 0 ? BLOCK_AIR : static_cast<BlockType>(WATER_FLOW_1 + std::min(level, 7) - 1);
+}
+
+bool isWater(BlockType type) {
+    return waterLevel(type) > 0;
+}
+
+// 实心方块: 阻挡移动, 水流不能进入
+bool isSolidBlock(BlockType type) {
+    return type != BLOCK_AIR && !isWater(type);
+}
+
 // 透明方块列表
 const BlockType transparentBlocks[] = {
     BLOCK_AIR,
@@ -20,12 +54,33 @@ const BlockType transparentBlocks[] = {
     GLASS_BLOCK
 };
 
-// 判断方块是否透明
+// 判断方块是否透明 (水也是透明的)
 bool isTransparent(BlockType type) {
+    if (isWater(type)) {
+        return true;
+    }
     for (BlockType transparentBlock : transparentBlocks) {
         if (type == transparentBlock) {
             return true;
         }
     }
     return false;
-}
\ No newline at end of file
+}
+
+const int MAX_LIGHT = 15; // 最高光照等级
+
+// 光线穿过方块时额外衰减的等级: 空气和玻璃不衰减, 树叶和水衰减 1 级, 不透明方块完全阻挡
+int lightOpacity(BlockType type) {
+    if (!isTransparent(type)) return MAX_LIGHT;
+    return type == OAK_LEAVES || isWater(type) ? 1 : 0;
+}
+
+// 方块自身发出的光照等级
+int lightEmission(BlockType type) {
+    return type == GLOWSTONE ? MAX_LIGHT : 0;
+}
+
+// 判断方块是否受重力影响 (下方为空气时下落)
+bool isGravityBlock(BlockType type) {
+    return type == SAND_BLOCK;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <vector>
+#include <queue>
+#include <unordered_set>
+#include <functional>
+#include <algorithm>
+#include "Chunk.hpp"
+
+/*
+    方块更新调度: 每个区块一个按到期模拟步排序的优先队列, 元素为 (到期步, 方块坐标)
+    方块或其相邻方块被修改时由 World 登记更新, 每个模拟步最多执行 maxUpdatesPerTick 个到期的更新,
+    未执行完的留到下一步, 连锁反应 (如整列沙子下落) 因此被分摊到多个模拟步, 不会造成卡顿
+    同一个方块在队列中最多登记一次; 只在主线程使用
+*/
+class BlockTickScheduler {
+public:
+    int maxUpdatesPerTick = 64;   // 每个模拟步最多执行的更新数
+    long long currentTick = 0;    // 已推进的模拟步数
+
+    // 统计 (供调试界面显示)
+    int lastUpdates = 0;          // 上一步执行的更新数
+    long long totalUpdates = 0;
+
+    BlockTickScheduler(int chunksX, int chunksZ, int worldHeight)
+        : chunksX(chunksX), chunksZ(chunksZ), worldHeight(worldHeight), queues(chunksX * chunksZ) {}
+
+    // 登记方块 (x, y, z) 在 delay 步之后更新; 已登记且尚未执行的不重复登记
+    void schedule(int x, int y, int z, int delay) {
+        if (x < 0 || y < 0 || z < 0 || y >= worldHeight || x / CHUNK_SIZE >= chunksX || z / CHUNK_SIZE >= chunksZ) return;
+        int chunkIndex = (x / CHUNK_SIZE) * chunksZ + z / CHUNK_SIZE;
+        ChunkQueue& queue = queues[chunkIndex];
+        if (!queue.pending.insert(ChunkGrid::blockIndex(x % CHUNK_SIZE, y, z % CHUNK_SIZE)).second) return;
+        if (!queue.active) {
+            queue.active = true;
+            activeChunks.push_back(chunkIndex);
+        }
+        queue.events.push({ currentTick + std::max(1, delay), x, y, z });
+        pendingCount++;
+    }
+
+    // 推进一个模拟步, 对到期的方块调用 update(x, y, z) (update 中可以登记新的更新)
+    void tick(const std::function<void(int, int, int)>& update) {
+        currentTick++;
+        int budget = maxUpdatesPerTick;
+        // 从上次停下的区块开始轮流处理, 预算不足时各区块都有机会执行
+        size_t count = activeChunks.size();
+        std::vector<Event> due;
+        for (size_t n = 0; n < count && budget > 0; ++n) {
+            ChunkQueue& queue = queues[activeChunks[(nextChunk + n) % count]];
+            while (!queue.events.empty() && queue.events.top().tick <= currentTick && budget > 0) {
+                Event event = queue.events.top();
+                queue.events.pop();
+                queue.pending.erase(ChunkGrid::blockIndex(event.x % CHUNK_SIZE, event.y, event.z % CHUNK_SIZE));
+                due.push_back(event);
+                budget--;
+            }
+        }
+        nextChunk = count > 0 ? (nextChunk + 1) % count : 0;
+
+        // 先取出再执行, update 登记的新事件不会在本步内被执行
+        for (const Event& event : due) {
+            update(event.x, event.y, event.z);
+        }
+        pendingCount -= (long long)due.size();
+        lastUpdates = (int)due.size();
+        totalUpdates += due.size();
+
+        activeChunks.erase(std::remove_if(activeChunks.begin(), activeChunks.end(), [this](int index) {
+            if (!queues[index].events.empty()) return false;
+            queues[index].active = false;
+            return true;
+        }), activeChunks.end());
+    }
+
+    long long pending() const {
+        return pendingCount;
+    }
+
+private:
+    struct Event {
+        long long tick;
+        int x, y, z;
+        bool operator>(const Event& other) const {
+            return tick > other.tick;
+        }
+    };
+
+    struct ChunkQueue {
+        std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+        std::unordered_set<int> pending;  // 已登记的方块 (区块内下标)
+        bool active = false;              // 是否在 activeChunks 中
+    };
+
+    int chunksX, chunksZ, worldHeight;
+    std::vector<ChunkQueue> queues;
+    std::vector<int> activeChunks;        // 队列非空的区块
+    size_t nextChunk = 0;
+    long long pendingCount = 0;
+};
@@ -0,0 +1,179 @@
+#pragma once
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include "Block.hpp"
+#include "ChunkSection.hpp"
+
+const int CHUNK_SIZE = 16; // 区块在 x/z 方向上的边长
+
+// 区块生命周期的各个阶段, 按顺序推进
+enum ChunkState {
+    CHUNK_EMPTY,      // 尚未请求
+    CHUNK_REQUESTED,  // 已请求, 等待生成
+    CHUNK_GENERATED,  // 地形已生成
+    CHUNK_DECORATED,  // 树木等装饰已放置 (可能写入相邻区块)
+    CHUNK_MESHED,     // 网格已在 CPU 上构建完成
+    CHUNK_UPLOADED,   // 网格已上传到 GPU
+    CHUNK_VISIBLE     // 位于视野内, 参与绘制
+};
+
+struct Chunk {
+    int cx = 0, cz = 0;                   // 区块坐标
+    // 方块类型, 下标见 ChunkGrid::blockIndex; 冷区块压缩后为空, 读取时由 ChunkGrid 透明解压, 因此 const 访问也可能修改
+    mutable std::vector<uint8_t> blocks;
+    mutable std::vector<SectionRef> packedSections; // 压缩后各段的共享数据 (见 SectionStore), 仅在 packed 时有效
+    mutable std::atomic<bool> packed{false};
+    std::vector<int> heightMap;           // 每列的地表高度 (CHUNK_SIZE * CHUNK_SIZE)
+    std::vector<float> biomeMap;          // 每列的生物群系噪声, 生成阶段缓存, 装饰阶段直接读取
+    std::vector<uint8_t> light;           // 每个格子的光照 (见 LightEngine), 下标同 blocks; 构建网格时计算, 卸载网格时释放
+    std::vector<float> meshVertices;      // 构建好但尚未上传的顶点数据
+    const float* cachedMesh = nullptr;    // 网格缓存命中时指向映射的缓存文件, 上传时代替 meshVertices
+    size_t cachedMeshFloats = 0;
+    std::atomic<int> state{CHUNK_EMPTY};  // 当前阶段 (ChunkState)
+    std::atomic<bool> jobPending{false};  // 是否有进行中的异步任务
+};
+
+// 覆盖整个有限世界的区块网格
+class ChunkGrid {
+public:
+    int worldWidth, worldHeight, worldDepth;
+    int chunksX, chunksZ;
+    std::vector<Chunk> chunks;
+
+    // 冷区块压缩: 区块切分为段后在 sectionStore 中去重, 内容相同的段只保存一份; 只用于压缩形式, 解压后区块持有私有数组
+    SectionStore sectionStore;
+    mutable std::atomic<int> packedChunks{0};          // 当前处于压缩状态的区块数
+    mutable std::atomic<long long> unpackCount{0};
+    mutable std::atomic<long long> unpackNanos{0};     // 累计解压耗时
+    mutable std::atomic<long long> maxUnpackNanos{0};
+
+    ChunkGrid(int w, int h, int d) : worldWidth(w), worldHeight(h), worldDepth(d) {
+        chunksX = (worldWidth + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        chunksZ = (worldDepth + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        chunks = std::vector<Chunk>(chunksX * chunksZ);
+        for (int cx = 0; cx < chunksX; ++cx) {
+            for (int cz = 0; cz < chunksZ; ++cz) {
+                Chunk& chunk = chunks[cx * chunksZ + cz];
+                chunk.cx = cx;
+                chunk.cz = cz;
+                chunk.blocks.resize(CHUNK_SIZE * CHUNK_SIZE * worldHeight, BLOCK_AIR);
+                chunk.heightMap.resize(CHUNK_SIZE * CHUNK_SIZE, 0);
+                chunk.biomeMap.resize(CHUNK_SIZE * CHUNK_SIZE, 0.0f);
+            }
+        }
+    }
+
+    bool isInsideWorld(int x, int y, int z) const {
+        return x >= 0 && x < worldWidth && y >= 0 && y < worldHeight && z >= 0 && z < worldDepth;
+    }
+
+    bool hasChunk(int cx, int cz) const {
+        return cx >= 0 && cx < chunksX && cz >= 0 && cz < chunksZ;
+    }
+
+    Chunk* getChunk(int cx, int cz) {
+        return hasChunk(cx, cz) ? &chunks[cx * chunksZ + cz] : nullptr;
+    }
+
+    const Chunk* getChunk(int cx, int cz) const {
+        return hasChunk(cx, cz) ? &chunks[cx * chunksZ + cz] : nullptr;
+    }
+
+    // 区块内的方块下标, y 在最外层, 便于以水平切片为单位处理
+    static int blockIndex(int lx, int y, int lz) {
+        return (y * CHUNK_SIZE + lz) * CHUNK_SIZE + lx;
+    }
+
+    BlockType getBlock(int x, int y, int z) const {
+        if (!isInsideWorld(x, y, z)) {
+            return BlockType::BLOCK_AIR;
+        }
+        const Chunk& chunk = chunks[(x / CHUNK_SIZE) * chunksZ + z / CHUNK_SIZE];
+        if (chunk.blocks.empty()) unpack(chunk); // 被压缩的冷区块
+        return static_cast<BlockType>(chunk.blocks[blockIndex(x % CHUNK_SIZE, y, z % CHUNK_SIZE)]);
+    }
+
+    // 不检查压缩状态的 getBlock, 供构建网格等热点使用; 调用方须先用 unpackAround 解压涉及的区块
+    BlockType getResidentBlock(int x, int y, int z) const {
+        if (!isInsideWorld(x, y, z)) {
+            return BlockType::BLOCK_AIR;
+        }
+        const Chunk& chunk = chunks[(x / CHUNK_SIZE) * chunksZ + z / CHUNK_SIZE];
+        return static_cast<BlockType>(chunk.blocks[blockIndex(x % CHUNK_SIZE, y, z % CHUNK_SIZE)]);
+    }
+
+    void setBlock(int x, int y, int z, BlockType type) {
+        if (!isInsideWorld(x, y, z)) {
+            return;
+        }
+        Chunk& chunk = chunks[(x / CHUNK_SIZE) * chunksZ + z / CHUNK_SIZE];
+        if (chunk.blocks.empty()) unpack(chunk); // 被压缩的冷区块
+        chunk.blocks[blockIndex(x % CHUNK_SIZE, y, z % CHUNK_SIZE)] = type;
+    }
+
+    // 压缩区块: 按段在 sectionStore 中查找或加入共享段, 然后释放原数组; 调用方保证此时没有其他线程读写该区块
+    void pack(Chunk& chunk) {
+        if (chunk.packed.load(std::memory_order_acquire)) return;
+        const int layerBytes = CHUNK_SIZE * CHUNK_SIZE;
+        std::vector<SectionRef> sections;
+        for (int y0 = 0; y0 < worldHeight; y0 += SECTION_HEIGHT) {
+            int height = std::min(SECTION_HEIGHT, worldHeight - y0);
+            sections.push_back(sectionStore.intern(chunk.blocks.data() + y0 * layerBytes, height * layerBytes));
+        }
+        std::lock_guard<std::mutex> lock(packMutex);
+        chunk.packedSections.swap(sections);
+        std::vector<uint8_t>().swap(chunk.blocks);
+        chunk.packed.store(true, std::memory_order_release);
+        packedChunks++;
+    }
+
+    // 还原被压缩的区块 (可在任意线程调用)
+    void unpack(const Chunk& chunk) const {
+        std::lock_guard<std::mutex> lock(packMutex);
+        if (!chunk.packed.load(std::memory_order_relaxed)) return;
+        auto start = std::chrono::steady_clock::now();
+        chunk.blocks.resize(CHUNK_SIZE * CHUNK_SIZE * worldHeight);
+        uint8_t* out = chunk.blocks.data();
+        for (const SectionRef& section : chunk.packedSections) {
+            SectionStore::decode(*section, out); // 复制出私有的方块数据, 之后的修改不影响共享段
+            out += section->length;
+        }
+        long long nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        packedChunks--;
+        std::vector<SectionRef>().swap(chunk.packedSections);
+        chunk.packed.store(false, std::memory_order_release);
+        unpackCount++;
+        unpackNanos += nanos;
+        if (nanos > maxUnpackNanos.load()) maxUnpackNanos = nanos;
+    }
+
+    // 解压以 (cx, cz) 为中心的 3x3 区块 (构建网格前调用, 工作线程只读取已解压的区块)
+    void unpackAround(int cx, int cz) const {
+        for (int dx = -1; dx <= 1; ++dx) {
+            for (int dz = -1; dz <= 1; ++dz) {
+                const Chunk* neighbor = getChunk(cx + dx, cz + dz);
+                if (neighbor && neighbor->packed.load(std::memory_order_acquire)) unpack(*neighbor);
+            }
+        }
+    }
+
+    // 以 (cx, cz) 为中心的 3x3 区块是否都已达到某个阶段 (世界外的区块视为满足)
+    bool neighborsReached(int cx, int cz, ChunkState minState) const {
+        for (int dx = -1; dx <= 1; ++dx) {
+            for (int dz = -1; dz <= 1; ++dz) {
+                const Chunk* neighbor = getChunk(cx + dx, cz + dz);
+                if (neighbor && neighbor->state.load(std::memory_order_acquire) < minState) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+private:
+    mutable std::mutex packMutex;
+};
@@ -0,0 +1,49 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include "Chunk.hpp"
+#include "RegionFile.hpp"
+
+/*
+    区块磁盘缓存: 按地图种子保存生成并装饰完成的区块 (不含玩家的修改)
+    区块保存在 cache/<种子>/ 下的区域文件中 (见 RegionFile), 文件头记录种子、生成器版本和世界高度,
+    与当前不一致的区域文件会被重新创建, 生成算法改变后旧缓存自动失效
+    可以在多个工作线程中同时调用
+*/
+class ChunkCache {
+public:
+    ChunkCache(const std::string& root, int seed, int worldHeight, uint32_t generatorVersion)
+        : storage(root + "/" + std::to_string(seed), makeHeader(seed, worldHeight, generatorVersion), false) { // 缓存可以重新生成, 不落盘
+    }
+
+    const std::string& getDirectory() const {
+        return storage.getDirectory();
+    }
+
+    // 从磁盘载入区块的方块、高度图和生物群系缓存; 不存在或数据损坏时返回 false
+    bool load(Chunk& chunk) {
+        return storage.load(chunk);
+    }
+
+    bool save(const Chunk& chunk) {
+        return storage.save(chunk);
+    }
+
+    long long diskBytes() {
+        return storage.diskBytes();
+    }
+
+    // 缓存区域文件的文件头 (也供 worldtool 直接创建 RegionStorage)
+    static RegionFile::FileHeader makeHeader(int seed, int worldHeight, uint32_t generatorVersion) {
+        RegionFile::FileHeader header = {};
+        header.magic = RegionFile::fileMagic;
+        header.formatVersion = RegionFile::formatVersion;
+        header.generatorVersion = generatorVersion;
+        header.seed = seed;
+        header.worldHeight = worldHeight;
+        return header;
+    }
+
+private:
+    RegionStorage storage;
+};
@@ -0,0 +1,73 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include "Chunk.hpp"
+#include "RunLength.hpp"
+
+/*
+    区块序列化与压缩
+    方块数组用游程编码 (RLE, 见 RunLength) 压缩; 压缩后不比原始数据小时直接保存原始字节, 解码只需一次 memcpy
+*/
+namespace ChunkCodec {
+    enum Codec : uint32_t {
+        CODEC_RAW = 0,  // 原始字节
+        CODEC_RLE = 1,  // (长度 1..255, 值) 字节对
+    };
+
+    // 序列化后的区块: 头部 + 方块数据 (按 codec 编码) + 高度图 (每列 1 字节) + 生物群系 (每列 float)
+    struct PayloadHeader {
+        uint32_t codec;
+        uint32_t blocksLength; // 编码后方块数据的字节数
+    };
+
+    // 把区块的方块、高度图和生物群系缓存序列化为一段字节
+    inline std::vector<uint8_t> encodeChunk(const Chunk& chunk) {
+        const int columns = CHUNK_SIZE * CHUNK_SIZE;
+        std::vector<uint8_t> payload(sizeof(PayloadHeader));
+        PayloadHeader header = { CODEC_RLE, 0 };
+        RunLength::encode(chunk.blocks.data(), chunk.blocks.size(), payload);
+        if (payload.size() - sizeof(PayloadHeader) >= chunk.blocks.size()) {
+            header.codec = CODEC_RAW;
+            payload.resize(sizeof(PayloadHeader));
+            payload.insert(payload.end(), chunk.blocks.begin(), chunk.blocks.end());
+        }
+        header.blocksLength = (uint32_t)(payload.size() - sizeof(PayloadHeader));
+        std::memcpy(payload.data(), &header, sizeof(header));
+
+        for (int i = 0; i < columns; ++i) {
+            payload.push_back((uint8_t)std::min(chunk.heightMap[i], 255));
+        }
+        size_t biomeOffset = payload.size();
+        payload.resize(biomeOffset + columns * sizeof(float));
+        std::memcpy(payload.data() + biomeOffset, chunk.biomeMap.data(), columns * sizeof(float));
+        return payload;
+    }
+
+    // 从一段字节 (可以直接指向内存映射的文件) 还原区块; 数据损坏时返回 false
+    inline bool decodeChunk(const uint8_t* data, size_t size, Chunk& chunk) {
+        const int columns = CHUNK_SIZE * CHUNK_SIZE;
+        PayloadHeader header;
+        if (size < sizeof(header)) return false;
+        std::memcpy(&header, data, sizeof(header));
+        if (size != sizeof(header) + header.blocksLength + columns * (1 + sizeof(float))) return false;
+
+        const uint8_t* blocks = data + sizeof(header);
+        if (header.codec == CODEC_RAW) {
+            if (header.blocksLength != chunk.blocks.size()) return false;
+            std::memcpy(chunk.blocks.data(), blocks, chunk.blocks.size());
+        } else if (header.codec == CODEC_RLE) {
+            if (!RunLength::decode(blocks, header.blocksLength, chunk.blocks.data(), chunk.blocks.size())) return false;
+        } else {
+            return false;
+        }
+
+        const uint8_t* heights = blocks + header.blocksLength;
+        for (int i = 0; i < columns; ++i) {
+            chunk.heightMap[i] = heights[i];
+        }
+        std::memcpy(chunk.biomeMap.data(), heights + columns, columns * sizeof(float));
+        return true;
+    }
+}
@@ -0,0 +1,94 @@
+#pragma once
+#include <vector>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include "Chunk.hpp"
+
+/*
+    冷区块压缩: 长时间未被访问的区块在内存中按段去重并用 RLE 压缩 (见 SectionStore), 读取时由 ChunkGrid 透明解压
+    区块有网格 (位于视野半径内)、有进行中的任务、或被解压过都算一次访问;
+    空闲超过 coldSeconds 秒的区块被压缩, 未压缩的方块数据超过 residentBudgetBytes 时,
+    按最久未访问的顺序继续压缩 (至少空闲 minIdleSeconds 秒), 直到回到预算以内
+    只在主线程调用: 工作线程只通过流水线任务访问区块, 任务提交也在主线程, 因此跳过有任务的区块及其邻居即可避免竞争
+*/
+class ChunkCompressor {
+public:
+    float coldSeconds = 60.0f;                     // 空闲多久后压缩
+    float minIdleSeconds = 5.0f;                   // 超出预算时, 至少空闲这么久才压缩 (避免反复压缩解压)
+    long long residentBudgetBytes = 6LL << 20;     // 未压缩方块数据的内存预算
+    float checkInterval = 1.0f;                    // 检查间隔 (秒)
+
+    explicit ChunkCompressor(ChunkGrid& grid) : grid(grid), lastAccess(grid.chunks.size(), Clock::now()), wasPacked(grid.chunks.size(), 0) {
+        chunkBytes = (long long)CHUNK_SIZE * CHUNK_SIZE * grid.worldHeight;
+    }
+
+    // 每帧在主线程调用; canPack 可以排除其他模块仍在使用的区块 (如存档中尚未保存的区块)
+    void update(const std::function<bool(int)>& canPack) {
+        Clock::time_point now = Clock::now();
+        if (std::chrono::duration<float>(now - lastCheck).count() < checkInterval) return;
+        lastCheck = now;
+
+        std::vector<int> candidates;
+        for (int index = 0; index < (int)grid.chunks.size(); ++index) {
+            const Chunk& chunk = grid.chunks[index];
+            bool packed = chunk.packed.load(std::memory_order_acquire);
+            int state = chunk.state.load(std::memory_order_acquire);
+            bool busy = chunk.jobPending.load(std::memory_order_acquire);
+            if (state >= CHUNK_MESHED || busy || (wasPacked[index] && !packed)) {
+                lastAccess[index] = now;
+            }
+            wasPacked[index] = packed;
+            if (!packed && state == CHUNK_DECORATED && !busy && idleSeconds(index, now) >= minIdleSeconds) {
+                candidates.push_back(index);
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), [this](int a, int b) { return lastAccess[a] < lastAccess[b]; });
+
+        long long resident = residentBytes();
+        for (int index : candidates) {
+            if (idleSeconds(index, now) < coldSeconds && resident <= residentBudgetBytes) break; // 其余的更近期被访问过
+            Chunk& chunk = grid.chunks[index];
+            if (neighborBusy(chunk) || !canPack(index)) continue;
+            grid.pack(chunk);
+            wasPacked[index] = 1;
+            resident -= chunkBytes;
+        }
+        grid.sectionStore.prune(); // 释放已解压区块不再引用的段
+    }
+
+    // 未压缩的方块数据占用的字节数
+    long long residentBytes() const {
+        return (long long)(grid.chunks.size() - grid.packedChunks.load()) * chunkBytes;
+    }
+
+    // 压缩区块的原始大小与去重、压缩后大小之比
+    float compressionRatio() const {
+        long long packedBytes = grid.sectionStore.bytes();
+        return packedBytes > 0 ? (float)(grid.packedChunks.load() * chunkBytes) / packedBytes : 0.0f;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    ChunkGrid& grid;
+    std::vector<Clock::time_point> lastAccess;   // 每个区块最后一次被访问的时间
+    std::vector<char> wasPacked;                 // 上次检查时是否处于压缩状态
+    Clock::time_point lastCheck;
+    long long chunkBytes;
+
+    float idleSeconds(int index, Clock::time_point now) const {
+        return std::chrono::duration<float>(now - lastAccess[index]).count();
+    }
+
+    // 周围区块有任务时 (如正在构建网格), 工作线程可能正在读取该区块
+    bool neighborBusy(const Chunk& chunk) const {
+        for (int dx = -1; dx <= 1; ++dx) {
+            for (int dz = -1; dz <= 1; ++dz) {
+                const Chunk* neighbor = grid.getChunk(chunk.cx + dx, chunk.cz + dz);
+                if (neighbor && neighbor->jobPending.load(std::memory_order_acquire)) return true;
+            }
+        }
+        return false;
+    }
+};
@@ -0,0 +1,422 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <thread>
+#include "ThreadPool.hpp"
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+/*
+    区块存储的异步 I/O 后端
+    调用方把一批按扇区对齐的读写请求交给后端, execute 返回时全部完成:
+      pool  - 线程池中逐个执行 pread/pwrite (所有平台可用)
+      uring - Linux io_uring, 一次系统调用提交整批请求并收取完成事件
+    direct 模式绕过页缓存 (O_DIRECT / FILE_FLAG_NO_BUFFERING), 要求缓冲区、偏移和长度都按 IO_ALIGNMENT 对齐
+*/
+const int IO_ALIGNMENT = 4096;
+
+// 后端使用的文件句柄
+class IOFile {
+public:
+    IOFile() = default;
+    IOFile(const IOFile&) = delete;
+    IOFile& operator=(const IOFile&) = delete;
+
+    ~IOFile() {
+        close();
+    }
+
+    // 以读写方式打开已存在的文件; direct 打开失败时退回普通模式
+    bool open(const std::string& path, bool direct) {
+        close();
+#ifdef _WIN32
+        DWORD flags = FILE_ATTRIBUTE_NORMAL | (direct ? FILE_FLAG_NO_BUFFERING : 0);
+        handle = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                             nullptr, OPEN_EXISTING, flags, nullptr);
+        if (handle == INVALID_HANDLE_VALUE && direct) return open(path, false);
+        isDirect = direct && handle != INVALID_HANDLE_VALUE;
+        return handle != INVALID_HANDLE_VALUE;
+#else
+        int flags = O_RDWR;
+#ifdef O_DIRECT
+        if (direct) flags |= O_DIRECT;
+#endif
+        fd = ::open(path.c_str(), flags);
+        if (fd < 0 && direct) return open(path, false);
+        isDirect = direct && fd >= 0;
+        return fd >= 0;
+#endif
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (handle != INVALID_HANDLE_VALUE) CloseHandle(handle);
+        handle = INVALID_HANDLE_VALUE;
+#else
+        if (fd >= 0) ::close(fd);
+        fd = -1;
+#endif
+    }
+
+    bool direct() const {
+        return isDirect;
+    }
+
+    // 在 offset 处同步读写, 返回字节数, 失败时返回负数
+    int64_t read(uint64_t offset, void* buffer, uint32_t length) {
+#ifdef _WIN32
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = (DWORD)offset;
+        overlapped.OffsetHigh = (DWORD)(offset >> 32);
+        DWORD done = 0;
+        return ReadFile(handle, buffer, length, &done, &overlapped) ? (int64_t)done : -(int64_t)GetLastError();
+#else
+        ssize_t done = pread(fd, buffer, length, (off_t)offset);
+        return done >= 0 ? done : -errno;
+#endif
+    }
+
+    int64_t write(uint64_t offset, const void* buffer, uint32_t length) {
+#ifdef _WIN32
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = (DWORD)offset;
+        overlapped.OffsetHigh = (DWORD)(offset >> 32);
+        DWORD done = 0;
+        return WriteFile(handle, buffer, length, &done, &overlapped) ? (int64_t)done : -(int64_t)GetLastError();
+#else
+        ssize_t done = pwrite(fd, buffer, length, (off_t)offset);
+        return done >= 0 ? done : -errno;
+#endif
+    }
+
+    // 把已写入的数据落盘 (fsync / FlushFileBuffers)
+    bool sync() {
+#ifdef _WIN32
+        return handle != INVALID_HANDLE_VALUE && FlushFileBuffers(handle);
+#else
+        return fd >= 0 && fsync(fd) == 0;
+#endif
+    }
+
+#ifndef _WIN32
+    int descriptor() const {
+        return fd;
+    }
+#endif
+
+private:
+    bool isDirect = false;
+#ifdef _WIN32
+    HANDLE handle = INVALID_HANDLE_VALUE;
+#else
+    int fd = -1;
+#endif
+};
+
+/*
+    用 from 替换 to, 掉电后也只会看到其中一个完整的文件: 调用方先 sync 好 from 的内容,
+    改名后再把所在目录落盘 (Windows 上由 MOVEFILE_WRITE_THROUGH 保证改名写入磁盘后才返回)
+*/
+inline bool replaceFileDurably(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+    return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    if (::rename(from.c_str(), to.c_str()) != 0) return false;
+    size_t slash = to.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : to.substr(0, slash);
+    int fd = ::open(directory.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    bool synced = fsync(fd) == 0;
+    ::close(fd);
+    return synced;
+#endif
+}
+
+// 按 IO_ALIGNMENT 对齐的缓冲区
+class AlignedBuffer {
+public:
+    void resize(size_t size) {
+        storage.resize(size + IO_ALIGNMENT);
+        uintptr_t address = reinterpret_cast<uintptr_t>(storage.data());
+        offset = (size_t)((IO_ALIGNMENT - address % IO_ALIGNMENT) % IO_ALIGNMENT);
+        length = size;
+    }
+
+    uint8_t* data() {
+        return storage.data() + offset;
+    }
+
+    size_t size() const {
+        return length;
+    }
+
+private:
+    std::vector<uint8_t> storage;
+    size_t offset = 0;
+    size_t length = 0;
+};
+
+struct IORequest {
+    IOFile* file = nullptr;
+    uint64_t offset = 0;
+    uint32_t length = 0;
+    uint8_t* buffer = nullptr;
+    bool write = false;
+    int64_t result = 0;     // 完成的字节数, 失败时为负数
+    float latencyMs = 0.0f; // 从提交到完成的时间
+};
+
+class ChunkIOBackend {
+public:
+    virtual ~ChunkIOBackend() = default;
+    virtual const char* name() const = 0;
+    // 执行一批请求, 全部完成后返回; 可以在多个线程中同时调用
+    virtual void execute(std::vector<IORequest>& requests) = 0;
+};
+
+// 线程池中逐个执行 pread/pwrite
+class ThreadPoolIOBackend : public ChunkIOBackend {
+public:
+    explicit ThreadPoolIOBackend(int threads) : pool(threads) {
+    }
+
+    const char* name() const override {
+        return "pool";
+    }
+
+    void execute(std::vector<IORequest>& requests) override {
+        using Clock = std::chrono::steady_clock;
+        Clock::time_point submitted = Clock::now();
+        std::mutex doneMutex;
+        std::condition_variable doneCondition;
+        size_t remaining = requests.size();
+        for (IORequest& request : requests) {
+            pool.submit({ 0.0f, 0, [&, submitted]() {
+                request.result = request.write ? request.file->write(request.offset, request.buffer, request.length)
+                                               : request.file->read(request.offset, request.buffer, request.length);
+                request.latencyMs = std::chrono::duration<float, std::milli>(Clock::now() - submitted).count();
+                std::lock_guard<std::mutex> lock(doneMutex);
+                if (--remaining == 0) doneCondition.notify_one();
+            }, nullptr });
+        }
+        std::unique_lock<std::mutex> lock(doneMutex);
+        doneCondition.wait(lock, [&] { return remaining == 0; });
+    }
+
+private:
+    ThreadPool pool;
+};
+
+#ifdef __linux__
+// Linux io_uring (直接使用系统调用, 不依赖 liburing): 一次 io_uring_enter 提交整批请求并等待完成
+class UringIOBackend : public ChunkIOBackend {
+public:
+    explicit UringIOBackend(unsigned queueDepth = 128) {
+        io_uring_params params = {};
+        ringFd = (int)syscall(__NR_io_uring_setup, queueDepth, &params);
+        if (ringFd < 0) return;
+
+        size_t sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        size_t cqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (singleMap) sqSize = cqSize = std::max(sqSize, cqSize);
+        sqRing = mapRing(sqSize, IORING_OFF_SQ_RING);
+        cqRing = singleMap ? sqRing : mapRing(cqSize, IORING_OFF_CQ_RING);
+        sqes = static_cast<io_uring_sqe*>(mapRing(params.sq_entries * sizeof(io_uring_sqe), IORING_OFF_SQES));
+        sqRingSize = sqSize;
+        cqRingSize = singleMap ? 0 : cqSize;
+        sqeCount = params.sq_entries;
+        if (!sqRing || !cqRing || !sqes) {
+            release();
+            return;
+        }
+
+        uint8_t* sq = static_cast<uint8_t*>(sqRing);
+        uint8_t* cq = static_cast<uint8_t*>(cqRing);
+        sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        // IORING_OP_READ/WRITE 从 5.6 开始支持, 更早的内核对它们返回 -EINVAL; 探测失败也说明内核早于 5.6
+        if (!supportsReadWrite()) release();
+    }
+
+    ~UringIOBackend() override {
+        release();
+    }
+
+    // 内核不支持或被禁用 io_uring, 或早于 5.6 (不支持 IORING_OP_READ/WRITE) 时为 false
+    bool isAvailable() const {
+        return ringFd >= 0;
+    }
+
+    const char* name() const override {
+        return "uring";
+    }
+
+    /*
+        queued 为已写入提交队列、内核还没取走的请求数, inFlight 为内核已取走、尚未完成的请求数
+        io_uring_enter 可能只取走一部分 (返回值为实际取走的数量), 剩下的留在队列中下一轮再提交;
+        出错时不再提交新请求, 撤回队列中尚未取走的请求, 并等已取走的请求全部完成后才返回 (它们还在读写调用方的缓冲区)
+    */
+    void execute(std::vector<IORequest>& requests) override {
+        using Clock = std::chrono::steady_clock;
+        std::lock_guard<std::mutex> lock(mutex);
+        Clock::time_point submitted = Clock::now();
+        std::vector<char> finished(requests.size(), 0);
+        size_t next = 0, completed = 0;
+        unsigned queued = 0, inFlight = 0;
+        int error = 0;
+        bool waitFailed = false; // 出错后等待完成事件也失败, 改为轮询完成队列
+        while (completed < requests.size()) {
+            // 在队列深度允许的范围内填充提交队列
+            unsigned tail = *sqTail;
+            while (!error && next < requests.size() && inFlight + queued < sqeCount) {
+                IORequest& request = requests[next];
+                unsigned index = tail & sqMask;
+                io_uring_sqe& sqe = sqes[index];
+                std::memset(&sqe, 0, sizeof(sqe));
+                sqe.opcode = request.write ? IORING_OP_WRITE : IORING_OP_READ;
+                sqe.fd = request.file->descriptor();
+                sqe.off = request.offset;
+                sqe.addr = reinterpret_cast<uint64_t>(request.buffer);
+                sqe.len = request.length;
+                sqe.user_data = next;
+                sqArray[index] = index;
+                tail++;
+                next++;
+                queued++;
+            }
+            __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+            if (error && inFlight == 0) break;
+
+            // 提交并至少等待一个完成事件; 出错后只等待, 等待失败时直接轮询完成队列
+            int entered = 0;
+            if (!error || !waitFailed) {
+                entered = (int)syscall(__NR_io_uring_enter, ringFd, queued, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            } else {
+                std::this_thread::yield();
+            }
+            if (entered > 0) {
+                queued -= (unsigned)entered;
+                inFlight += (unsigned)entered;
+            } else if (entered < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                if (error) {
+                    waitFailed = true;
+                } else {
+                    error = errno;
+                }
+                // 撤回尚未被内核取走的请求 (持有 mutex, 内核只在 io_uring_enter 中读取提交队列)
+                __atomic_store_n(sqTail, __atomic_load_n(sqHead, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+                queued = 0;
+            }
+
+            unsigned head = *cqHead;
+            while (head != __atomic_load_n(cqTail, __ATOMIC_ACQUIRE)) {
+                const io_uring_cqe& cqe = cqes[head & cqMask];
+                IORequest& request = requests[cqe.user_data];
+                request.result = cqe.res;
+                request.latencyMs = std::chrono::duration<float, std::milli>(Clock::now() - submitted).count();
+                finished[cqe.user_data] = 1;
+                head++;
+                inFlight--;
+                completed++;
+            }
+            __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+        }
+
+        for (size_t i = 0; i < requests.size(); ++i) {
+            if (!finished[i]) requests[i].result = -error;
+        }
+    }
+
+private:
+    int ringFd = -1;
+    void* sqRing = nullptr;
+    void* cqRing = nullptr;
+    io_uring_sqe* sqes = nullptr;
+    size_t sqRingSize = 0, cqRingSize = 0;
+    unsigned sqeCount = 0;
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned* sqArray = nullptr;
+    unsigned sqMask = 0;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe* cqes = nullptr;
+    std::mutex mutex; // 一个环同时只处理一批请求
+
+    bool supportsReadWrite() {
+        const unsigned opCount = 256;
+        std::vector<uint8_t> storage(sizeof(io_uring_probe) + opCount * sizeof(io_uring_probe_op), 0);
+        io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(storage.data());
+        if (syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_PROBE, probe, opCount) < 0) return false;
+        auto supported = [probe](unsigned op) {
+            return op <= probe->last_op && op < probe->ops_len && (probe->ops[op].flags & IO_URING_OP_SUPPORTED);
+        };
+        return supported(IORING_OP_READ) && supported(IORING_OP_WRITE);
+    }
+
+    void* mapRing(size_t size, uint64_t offset) {
+        void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, (off_t)offset);
+        return address == MAP_FAILED ? nullptr : address;
+    }
+
+    void release() {
+        if (sqes) munmap(sqes, sqeCount * sizeof(io_uring_sqe));
+        if (cqRing && cqRing != sqRing) munmap(cqRing, cqRingSize);
+        if (sqRing) munmap(sqRing, sqRingSize);
+        if (ringFd >= 0) ::close(ringFd);
+        sqes = nullptr;
+        sqRing = cqRing = nullptr;
+        ringFd = -1;
+    }
+};
+#endif
+
+// 按名称创建后端 ("uring" 或 "pool"); io_uring 不可用时退回线程池
+inline std::unique_ptr<ChunkIOBackend> createChunkIOBackend(const std::string& name, int threads = 0) {
+#ifdef __linux__
+    if (name == "uring") {
+        std::unique_ptr<UringIOBackend> uring = std::make_unique<UringIOBackend>();
+        if (uring->isAvailable()) return uring;
+        std::cout << "[INFO] io_uring unavailable, falling back to thread pool I/O" << std::endl;
+    }
+#else
+    if (name == "uring") {
+        std::cout << "[INFO] io_uring is Linux only, falling back to thread pool I/O" << std::endl;
+    }
+#endif
+    return std::make_unique<ThreadPoolIOBackend>(threads);
+}
@@ -0,0 +1,326 @@
+#pragma once
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include "Chunk.hpp"
+#include "ThreadPool.hpp"
+
+// 区块流水线的各个阶段
+enum PipelineStage {
+    STAGE_GENERATE,   // REQUESTED -> GENERATED (工作线程)
+    STAGE_DECORATE,   // GENERATED -> DECORATED (工作线程, 需要 3x3 区块均已生成)
+    STAGE_MESH,       // DECORATED -> MESHED (工作线程, 需要 3x3 区块均已装饰)
+    STAGE_UPLOAD,     // MESHED -> UPLOADED (主线程, 需要 OpenGL 上下文)
+    STAGE_COUNT
+};
+
+const char* const pipelineStageNames[STAGE_COUNT] = { "Generate", "Decorate", "Mesh", "Upload" };
+
+// 单个阶段的统计信息
+struct StageStats {
+    int queued = 0;            // 等待中的任务数
+    long long completed = 0;   // 已完成的任务数
+    long long cancelled = 0;   // 因玩家远离而取消的任务数
+    double avgLatencyMs = 0.0; // 从入队到完成的平均耗时 (指数滑动平均)
+    double maxLatencyMs = 0.0; // 最大耗时
+    double totalWorkMs = 0.0;  // 阶段本身的累计执行时间 (不含排队), 用于计算吞吐量
+};
+
+/*
+    区块流水线: 每个区块依次经过 requested -> generated -> decorated -> meshed -> uploaded -> visible
+    异步阶段的优先级由区块到玩家的距离和与视线方向的夹角决定, 视野正前方的区块优先完成
+    区块超出 cancelRadius 时, 其等待中的任务会被取消
+*/
+class ChunkPipeline {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    int loadRadius = 12;           // 加载半径 (区块)
+    int cancelRadius = 14;         // 取消/卸载半径 (区块)
+    float viewAngleWeight = 2.0f;  // 视线夹角对优先级的影响权重
+
+    // 预测预取: 按玩家速度外推 prefetchSeconds 秒, 提前请求路径上的区块
+    float prefetchSeconds = 3.0f;  // 外推时长 (秒)
+    int prefetchWidth = 2;         // 路径两侧额外请求的区块数 (装饰和网格构建需要邻居)
+    float prefetchBoost = 0.25f;   // 路径上区块的优先级系数 (越小越优先)
+
+    // 各阶段的实际工作, 由 World 提供, 在工作线程中执行
+    std::function<bool(Chunk&)> loadStage;      // 可选: 生成之前尝试从磁盘载入已装饰的区块, 成功时跳过生成和装饰
+    std::function<void(Chunk&)> generateStage;
+    std::function<void(Chunk&)> decorateStage;
+    std::function<void(Chunk&)> meshStage;
+
+private:
+    ChunkGrid& grid;
+    ThreadPool pool;
+    glm::vec3 playerPos = glm::vec3(0.0f);
+    glm::vec2 viewDirXZ = glm::vec2(0.0f, -1.0f);
+
+    std::vector<Clock::time_point> stageStart;  // 每个区块进入当前阶段的时间
+    std::vector<Chunk*> uploadQueue;            // 等待上传的区块 (按优先级排序)
+    std::vector<char> prefetchMarks;            // 区块是否位于预测路径上
+    std::vector<int> prefetchChunks;            // 本帧预测路径上的区块索引
+    std::atomic<int> queuedJobs[STAGE_COUNT];
+    StageStats stats[STAGE_COUNT];
+    std::mutex statsMutex;
+
+    int chunkIndex(const Chunk& chunk) const {
+        return chunk.cx * grid.chunksZ + chunk.cz;
+    }
+
+    void recordLatency(PipelineStage stage, Clock::time_point start, double workMs) {
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        std::lock_guard<std::mutex> lock(statsMutex);
+        StageStats& s = stats[stage];
+        s.completed++;
+        s.totalWorkMs += workMs;
+        s.avgLatencyMs = s.completed == 1 ? ms : s.avgLatencyMs * 0.9 + ms * 0.1;
+        s.maxLatencyMs = std::max(s.maxLatencyMs, ms);
+    }
+
+    // 考虑预取加成后的区块优先级
+    float effectivePriority(const Chunk& chunk) const {
+        float priority = chunkPriority(chunk.cx, chunk.cz);
+        return prefetchMarks[chunkIndex(chunk)] ? priority * prefetchBoost : priority;
+    }
+
+    // 任务的优先级: 后面的阶段略微优先, 让已开始的区块尽快完成
+    float jobPriority(const Chunk& chunk, PipelineStage stage) const {
+        return effectivePriority(chunk) - stage * (float)CHUNK_SIZE;
+    }
+
+    // 沿 dir 方向以 speed 外推 duration 秒, 标记路径附近的区块
+    void markPrefetchPath(glm::vec2 dir, float speed, float duration) {
+        // 每半个区块取一个采样点
+        float timeStep = CHUNK_SIZE * 0.5f / speed;
+        for (float t = 0.0f; t <= duration; t += timeStep) {
+            glm::vec2 predicted = glm::vec2(playerPos.x, playerPos.z) + dir * speed * t;
+            int pcx = (int)std::floor(predicted.x / CHUNK_SIZE);
+            int pcz = (int)std::floor(predicted.y / CHUNK_SIZE);
+            for (int cx = pcx - prefetchWidth; cx <= pcx + prefetchWidth; ++cx) {
+                for (int cz = pcz - prefetchWidth; cz <= pcz + prefetchWidth; ++cz) {
+                    if (!grid.hasChunk(cx, cz)) continue;
+                    int index = cx * grid.chunksZ + cz;
+                    if (!prefetchMarks[index]) {
+                        prefetchMarks[index] = 1;
+                        prefetchChunks.push_back(index);
+                    }
+                }
+            }
+        }
+    }
+
+    // 按速度外推玩家位置; 视线方向与运动方向不同时, 玩家很可能转向视线方向, 沿视线再外推一半时长
+    void updatePrefetch(const glm::vec3& velocity) {
+        for (int index : prefetchChunks) {
+            prefetchMarks[index] = 0;
+        }
+        prefetchChunks.clear();
+
+        glm::vec2 velocityXZ(velocity.x, velocity.z);
+        float speed = glm::length(velocityXZ);
+        if (speed < 0.5f || prefetchSeconds <= 0.0f) {
+            return; // 几乎静止时普通加载已经足够
+        }
+        glm::vec2 moveDir = velocityXZ / speed;
+        markPrefetchPath(moveDir, speed, prefetchSeconds);
+        if (glm::dot(moveDir, viewDirXZ) < 0.9f) {
+            markPrefetchPath(viewDirXZ, speed, prefetchSeconds * 0.5f);
+        }
+    }
+
+    // 若条件满足, 为区块提交下一阶段的任务
+    void advanceChunk(Chunk& chunk) {
+        if (chunk.jobPending.load(std::memory_order_acquire)) return;
+
+        switch (chunk.state.load(std::memory_order_acquire)) {
+        case CHUNK_EMPTY:
+            chunk.state.store(CHUNK_REQUESTED);
+            submitStage(chunk, STAGE_GENERATE, [this](Chunk& target) {
+                if (loadStage && loadStage(target)) {
+                    return CHUNK_DECORATED;
+                }
+                generateStage(target);
+                return CHUNK_GENERATED;
+            });
+            break;
+        case CHUNK_GENERATED:
+            if (grid.neighborsReached(chunk.cx, chunk.cz, CHUNK_GENERATED)) {
+                submitStage(chunk, STAGE_DECORATE, [this](Chunk& target) {
+                    decorateStage(target);
+                    return CHUNK_DECORATED;
+                });
+            }
+            break;
+        case CHUNK_DECORATED:
+            if (grid.neighborsReached(chunk.cx, chunk.cz, CHUNK_DECORATED)) {
+                grid.unpackAround(chunk.cx, chunk.cz); // 工作线程构建网格时只读取已解压的区块
+                submitStage(chunk, STAGE_MESH, [this](Chunk& target) {
+                    meshStage(target);
+                    return CHUNK_MESHED;
+                });
+            }
+            break;
+        case CHUNK_MESHED:
+            uploadQueue.push_back(&chunk);
+            break;
+        default:
+            break;
+        }
+    }
+
+    // work 执行该阶段并返回区块到达的状态
+    void submitStage(Chunk& chunk, PipelineStage stage, std::function<ChunkState(Chunk&)> work) {
+        int index = chunkIndex(chunk);
+        chunk.jobPending.store(true);
+        stageStart[index] = Clock::now();
+        queuedJobs[stage]++;
+
+        ThreadPool::Job job;
+        job.priority = jobPriority(chunk, stage);
+        job.tag = index * STAGE_COUNT + stage;
+        job.task = [this, &chunk, stage, work, index]() {
+            queuedJobs[stage]--;
+            Clock::time_point workStart = Clock::now();
+            ChunkState doneState = work(chunk);
+            recordLatency(stage, stageStart[index], std::chrono::duration<double, std::milli>(Clock::now() - workStart).count());
+            if (doneState == CHUNK_MESHED) {
+                stageStart[index] = Clock::now(); // 上传阶段的计时从此开始
+            }
+            chunk.state.store(doneState, std::memory_order_release);
+            chunk.jobPending.store(false, std::memory_order_release);
+        };
+        job.onCancel = [this, &chunk, stage]() {
+            queuedJobs[stage]--;
+            {
+                std::lock_guard<std::mutex> lock(statsMutex);
+                stats[stage].cancelled++;
+            }
+            if (stage == STAGE_GENERATE) {
+                chunk.state.store(CHUNK_EMPTY);
+            }
+            chunk.jobPending.store(false);
+        };
+        pool.submit(std::move(job));
+    }
+
+public:
+    ChunkPipeline(ChunkGrid& grid, int threadCount = 0)
+        : grid(grid), pool(threadCount) {
+        stageStart.resize(grid.chunks.size());
+        prefetchMarks.resize(grid.chunks.size(), 0);
+        for (auto& count : queuedJobs) count = 0;
+    }
+
+    ~ChunkPipeline() {
+        stop();
+    }
+
+    // 停止工作线程; 必须在阶段回调所引用的数据销毁之前调用
+    void stop() {
+        pool.stop();
+    }
+
+    int threadCount() const {
+        return pool.threadCount();
+    }
+
+    // 区块优先级: 水平距离乘以视线夹角惩罚, 越小越优先
+    float chunkPriority(int cx, int cz) const {
+        glm::vec2 center(cx * CHUNK_SIZE + CHUNK_SIZE * 0.5f, cz * CHUNK_SIZE + CHUNK_SIZE * 0.5f);
+        glm::vec2 toChunk = center - glm::vec2(playerPos.x, playerPos.z);
+        float distance = glm::length(toChunk);
+        if (distance < CHUNK_SIZE) {
+            return distance; // 脚下的区块不考虑朝向
+        }
+        float cosAngle = glm::dot(toChunk / distance, viewDirXZ);
+        return distance * (1.0f + viewAngleWeight * (1.0f - cosAngle) * 0.5f);
+    }
+
+    // 区块到玩家所在区块的距离 (区块单位)
+    float chunkDistance(int cx, int cz) const {
+        float pcx = playerPos.x / CHUNK_SIZE - 0.5f;
+        float pcz = playerPos.z / CHUNK_SIZE - 0.5f;
+        return glm::length(glm::vec2(cx - pcx, cz - pcz));
+    }
+
+    // 超出取消半径且不在预测路径上
+    bool isBeyondCancelRadius(const Chunk& chunk) const {
+        return chunkDistance(chunk.cx, chunk.cz) > cancelRadius && !prefetchMarks[chunkIndex(chunk)];
+    }
+
+    // 每帧在主线程调用: 重新计算优先级, 取消过期任务, 推进各个区块的阶段
+    void update(const glm::vec3& position, const glm::vec3& viewDir, const glm::vec3& velocity) {
+        playerPos = position;
+        glm::vec2 dir(viewDir.x, viewDir.z);
+        if (glm::length(dir) > 0.001f) {
+            viewDirXZ = glm::normalize(dir);
+        }
+        updatePrefetch(velocity);
+
+        pool.reprioritize([this](ThreadPool::Job& job) {
+            const Chunk& chunk = grid.chunks[job.tag / STAGE_COUNT];
+            if (isBeyondCancelRadius(chunk)) {
+                return false;
+            }
+            job.priority = jobPriority(chunk, static_cast<PipelineStage>(job.tag % STAGE_COUNT));
+            return true;
+        });
+
+        uploadQueue.clear();
+        int pcx = (int)std::floor(playerPos.x / CHUNK_SIZE);
+        int pcz = (int)std::floor(playerPos.z / CHUNK_SIZE);
+        for (int cx = pcx - loadRadius; cx <= pcx + loadRadius; ++cx) {
+            for (int cz = pcz - loadRadius; cz <= pcz + loadRadius; ++cz) {
+                Chunk* chunk = grid.getChunk(cx, cz);
+                if (!chunk || chunkDistance(cx, cz) > loadRadius) continue;
+                advanceChunk(*chunk);
+            }
+        }
+
+        // 预测路径上加载半径之外的区块
+        for (int index : prefetchChunks) {
+            Chunk& chunk = grid.chunks[index];
+            if (chunkDistance(chunk.cx, chunk.cz) > loadRadius) {
+                advanceChunk(chunk);
+            }
+        }
+
+        std::sort(uploadQueue.begin(), uploadQueue.end(), [this](const Chunk* a, const Chunk* b) {
+            return effectivePriority(*a) > effectivePriority(*b);
+        });
+    }
+
+    // 取出本帧要上传的区块 (最多 budget 个, 优先级最高的在前)
+    std::vector<Chunk*> takeUploads(int budget) {
+        std::vector<Chunk*> result;
+        while (budget-- > 0 && !uploadQueue.empty()) {
+            result.push_back(uploadQueue.back());
+            uploadQueue.pop_back();
+        }
+        return result;
+    }
+
+    // 主线程完成上传后调用
+    void finishUpload(Chunk& chunk) {
+        recordLatency(STAGE_UPLOAD, stageStart[chunkIndex(chunk)], 0.0);
+        chunk.state.store(CHUNK_UPLOADED, std::memory_order_release);
+    }
+
+    // 阻塞直到所有等待中的任务执行完毕 (用于加载出生点)
+    void waitIdle() {
+        pool.waitIdle();
+    }
+
+    StageStats getStats(PipelineStage stage) {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        StageStats s = stats[stage];
+        s.queued = stage == STAGE_UPLOAD ? (int)uploadQueue.size() : queuedJobs[stage].load();
+        return s;
+    }
+};
@@ -0,0 +1,171 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include "RunLength.hpp"
+
+const int SECTION_HEIGHT = 4; // 区块按高度切分为段, 每段 16x4x16 个方块
+
+// 不可变的区块段: 内容相同的段在内存中只保存一份, 由多个被压缩的冷区块共享
+// (常驻区块仍使用各自连续的方块数组; 网格按段复用, 见 SectionMeshCache)
+struct ChunkSection {
+    uint64_t hash;                 // 编码后数据的哈希
+    uint32_t length;               // 原始方块数据的字节数
+    bool uniform;                  // 整段是同一种方块 (全空气、全石头等)
+    uint8_t uniformBlock;
+    std::vector<uint8_t> encoded;  // RLE 编码后的方块数据
+};
+using SectionRef = std::shared_ptr<const ChunkSection>;
+
+/*
+    区块段的去重表: 按内容哈希查找, 哈希相同时再比较内容, 内容相同则返回已有的段
+    被引用的段不可修改, 编辑时区块先解压出私有副本 (写时复制), 不再引用的段由 prune 释放
+    可以在多个线程中同时调用
+*/
+class SectionStore {
+public:
+    std::atomic<long long> lookups{0}; // intern 调用次数
+    std::atomic<long long> hits{0};    // 其中找到已有段的次数
+
+    // hash 可以传入上一段数据的哈希, 把多段数据连成一个哈希
+    static uint64_t hashBytes(const uint8_t* data, size_t size, uint64_t hash = 14695981039346656037ull) { // FNV-1a
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ data[i]) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // 返回内容为 data 的共享段; RLE 编码是确定的, 比较编码后的数据即可判断内容是否相同
+    SectionRef intern(const uint8_t* data, size_t size) {
+        std::vector<uint8_t> encoded;
+        RunLength::encode(data, size, encoded);
+        uint64_t hash = hashBytes(encoded.data(), encoded.size());
+        lookups++;
+
+        std::lock_guard<std::mutex> lock(mutex);
+        auto range = sections.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second->length == size && it->second->encoded == encoded) {
+                hits++;
+                return it->second;
+            }
+        }
+
+        std::shared_ptr<ChunkSection> section = std::make_shared<ChunkSection>();
+        section->hash = hash;
+        section->length = (uint32_t)size;
+        section->uniform = std::all_of(data, data + size, [&](uint8_t block) { return block == data[0]; });
+        section->uniformBlock = data[0];
+        encoded.shrink_to_fit();
+        section->encoded.swap(encoded);
+        sections.emplace(hash, section);
+        storedBytes += (long long)section->encoded.size();
+        return section;
+    }
+
+    // 解码段的方块数据到 out
+    static void decode(const ChunkSection& section, uint8_t* out) {
+        if (section.uniform) {
+            std::memset(out, section.uniformBlock, section.length);
+        } else {
+            RunLength::decode(section.encoded.data(), section.encoded.size(), out, section.length);
+        }
+    }
+
+    // 释放不再被任何区块引用的段
+    void prune() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = sections.begin(); it != sections.end();) {
+            if (it->second.use_count() == 1) {
+                storedBytes -= (long long)it->second->encoded.size();
+                it = sections.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    int uniqueCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return (int)sections.size();
+    }
+
+    // 去重表中所有段编码后的总字节数
+    long long bytes() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return storedBytes;
+    }
+
+    float hitRate() const {
+        long long total = lookups.load();
+        return total > 0 ? (float)hits.load() / total : 0.0f;
+    }
+
+private:
+    std::mutex mutex;
+    std::unordered_multimap<uint64_t, std::shared_ptr<ChunkSection>> sections;
+    long long storedBytes = 0;
+};
+
+/*
+    段网格的内存缓存: 键为段及外面一圈方块和光照的哈希 (与段的位置无关), 值为段内坐标的顶点
+    内容相同的段 (如同样的水面、被埋住的石头) 只构建一次网格, 之后平移到各自的位置
+    超出 maxBytes 时整表清空; 可以在多个线程中同时调用
+*/
+class SectionMeshCache {
+public:
+    using Mesh = std::shared_ptr<const std::vector<float>>;
+
+    std::atomic<long long> lookups{0};
+    std::atomic<long long> hits{0};
+    const size_t maxBytes = 32u << 20;
+
+    // 段内容的哈希, 每次处理 8 字节 (每个段都要计算, 逐字节的 FNV-1a 太慢)
+    static uint64_t hashKey(const uint8_t* data, size_t size, uint64_t seed) {
+        uint64_t hash = seed ^ (size * 0x9E3779B97F4A7C15ull);
+        size_t i = 0;
+        for (; i + 8 <= size; i += 8) {
+            uint64_t word;
+            std::memcpy(&word, data + i, 8);
+            hash = (hash ^ word) * 0xFF51AFD7ED558CCDull;
+            hash ^= hash >> 32;
+        }
+        for (; i < size; ++i) {
+            hash = (hash ^ data[i]) * 1099511628211ull;
+        }
+        return hash ^ (hash >> 29);
+    }
+
+    Mesh lookup(uint64_t key) {
+        lookups++;
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = meshes.find(key);
+        if (it == meshes.end()) return nullptr;
+        hits++;
+        return it->second;
+    }
+
+    void store(uint64_t key, const Mesh& mesh) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (storedBytes + mesh->size() * sizeof(float) > maxBytes) {
+            meshes.clear();
+            storedBytes = 0;
+        }
+        if (meshes.emplace(key, mesh).second) storedBytes += mesh->size() * sizeof(float);
+    }
+
+    float hitRate() const {
+        long long total = lookups.load();
+        return total > 0 ? (float)hits.load() / total : 0.0f;
+    }
+
+private:
+    std::mutex mutex;
+    std::unordered_map<uint64_t, Mesh> meshes;
+    size_t storedBytes = 0;
+};
@@ -0,0 +1,87 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cmath>
+
+/*
+    轴对齐包围盒 (AABB) 与方块网格的扫掠碰撞
+    包围盒按 X、Z、Y 的顺序逐轴移动, 每个轴上依次检查包围盒沿途扫过的每一层格子, 停在第一层含实心格子的位置 (碰撞时刻),
+    因此速度再大、时间步再长也不会穿过方块; 已经与包围盒重叠的格子不阻挡移动 (卡在方块里时仍可以走出来)
+    isSolid(x, y, z) 返回格子是否阻挡移动
+*/
+const float COLLISION_EPSILON = 1e-4f; // 贴合面上的舍入误差: 相距小于此值视为刚好接触而不重叠
+
+struct SweepResult {
+    glm::vec3 motion = glm::vec3(0.0f);    // 实际移动的距离
+    glm::ivec3 normal = glm::ivec3(0);     // 各轴上接触面的法线 (-1/0/1), 如 normal.y == 1 表示落在方块上
+};
+
+// 包围盒在某个轴上重叠的第一个和最后一个格子 (不含只是贴着边界的格子)
+inline int firstOverlappedCell(float minBound) {
+    return (int)std::floor(minBound + COLLISION_EPSILON);
+}
+inline int lastOverlappedCell(float maxBound) {
+    return (int)std::ceil(maxBound - COLLISION_EPSILON) - 1;
+}
+
+// 沿 axis 轴移动包围盒 distance, 返回实际移动的距离; 被挡住时 normal 为接触面的法线
+template <typename IsSolid>
+float sweepAxis(glm::vec3& minBound, glm::vec3& maxBound, int axis, float distance, IsSolid&& isSolid, int& normal) {
+    normal = 0;
+    if (distance == 0.0f) return 0.0f;
+    int b = (axis + 1) % 3, c = (axis + 2) % 3;
+    int b0 = firstOverlappedCell(minBound[b]), b1 = lastOverlappedCell(maxBound[b]);
+    int c0 = firstOverlappedCell(minBound[c]), c1 = lastOverlappedCell(maxBound[c]);
+
+    auto layerSolid = [&](int layer) {
+        glm::ivec3 cell;
+        cell[axis] = layer;
+        for (cell[b] = b0; cell[b] <= b1; ++cell[b]) {
+            for (cell[c] = c0; cell[c] <= c1; ++cell[c]) {
+                if (isSolid(cell.x, cell.y, cell.z)) return true;
+            }
+        }
+        return false;
+    };
+
+    float moved = distance;
+    if (distance > 0.0f) {
+        // 包围盒前方尚未重叠的格子, 直到移动后的前沿
+        for (int layer = lastOverlappedCell(maxBound[axis]) + 1; layer <= lastOverlappedCell(maxBound[axis] + distance); ++layer) {
+            if (layerSolid(layer)) {
+                moved = std::max(0.0f, layer - maxBound[axis]);
+                normal = -1;
+                break;
+            }
+        }
+    } else {
+        for (int layer = firstOverlappedCell(minBound[axis]) - 1; layer >= firstOverlappedCell(minBound[axis] + distance); --layer) {
+            if (layerSolid(layer)) {
+                moved = std::min(0.0f, layer + 1 - minBound[axis]);
+                normal = 1;
+                break;
+            }
+        }
+    }
+    minBound[axis] += moved;
+    maxBound[axis] += moved;
+    return moved;
+}
+
+// 按 X、Z、Y 的顺序移动包围盒 motion
+template <typename IsSolid>
+SweepResult sweepBox(glm::vec3 minBound, glm::vec3 maxBound, const glm::vec3& motion, IsSolid&& isSolid) {
+    SweepResult result;
+    for (int axis : { 0, 2, 1 }) {
+        result.motion[axis] = sweepAxis(minBound, maxBound, axis, motion[axis], isSolid, result.normal[axis]);
+    }
+    return result;
+}
+
+// 包围盒是否与某个格子重叠 (贴着表面不算)
+inline bool overlapsCell(const glm::vec3& minBound, const glm::vec3& maxBound, int x, int y, int z) {
+    glm::ivec3 cell(x, y, z);
+    for (int axis = 0; axis < 3; ++axis) {
+        if (cell[axis] < firstOverlappedCell(minBound[axis]) || cell[axis] > lastOverlappedCell(maxBound[axis])) return false;
+    }
+    return true;
+}
@@ -0,0 +1,289 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include "Collision.hpp"
+
+/*
+    均匀网格空间哈希 (宽相位): 按包围盒中心所在的格子把实体下标做计数排序, 同一桶的实体连续存放
+    格子边长不小于最大实体尺寸时, 互相重叠的实体一定位于相邻的 3x3x3 个格子内
+    每个实体记录自己的格子坐标, 查询时跳过哈希到同一个桶的其他格子, 因此每个实体最多被访问一次
+*/
+class SpatialHash {
+public:
+    float cellSize;
+
+    explicit SpatialHash(float cellSize) : cellSize(cellSize) {}
+
+    // 用 count 个点重建哈希表
+    void build(const float* x, const float* y, const float* z, int count) {
+        int buckets = 1;
+        while (buckets < count * 2) buckets <<= 1;
+        mask = buckets - 1;
+        bucketStart.assign(buckets + 1, 0);
+        cells.resize(count);
+        for (int i = 0; i < count; ++i) {
+            cells[i] = glm::ivec3(cellCoord(x[i]), cellCoord(y[i]), cellCoord(z[i]));
+            bucketStart[bucket(cells[i]) + 1]++;
+        }
+        for (int b = 0; b < buckets; ++b) {
+            bucketStart[b + 1] += bucketStart[b];
+        }
+        entries.resize(count);
+        fill.assign(bucketStart.begin(), bucketStart.end() - 1);
+        for (int i = 0; i < count; ++i) {
+            entries[fill[bucket(cells[i])]++] = { cells[i], i };
+        }
+    }
+
+    // 对点 (x, y, z) 所在格子及其相邻的 26 个格子中的每个实体调用 visit(index)
+    template <typename Visit>
+    void forEachNear(float x, float y, float z, Visit&& visit) const {
+        if (entries.empty()) return;
+        glm::ivec3 center(cellCoord(x), cellCoord(y), cellCoord(z));
+        glm::ivec3 cell;
+        for (cell.x = center.x - 1; cell.x <= center.x + 1; ++cell.x) {
+            for (cell.y = center.y - 1; cell.y <= center.y + 1; ++cell.y) {
+                for (cell.z = center.z - 1; cell.z <= center.z + 1; ++cell.z) {
+                    uint32_t b = bucket(cell);
+                    for (int e = bucketStart[b]; e < bucketStart[b + 1]; ++e) {
+                        if (entries[e].cell == cell) visit(entries[e].index);
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    struct Entry {
+        glm::ivec3 cell;
+        int index;
+    };
+
+    uint32_t mask = 0;
+    std::vector<int> bucketStart;     // 每个桶在 entries 中的起始位置
+    std::vector<int> fill;            // 建表时各桶的写入位置
+    std::vector<Entry> entries;       // 按桶排序的实体
+    std::vector<glm::ivec3> cells;    // 每个实体所在的格子
+
+    int cellCoord(float v) const {
+        return (int)std::floor(v / cellSize);
+    }
+
+    uint32_t bucket(const glm::ivec3& cell) const {
+        return ((uint32_t)cell.x * 73856093u ^ (uint32_t)cell.y * 19349663u ^ (uint32_t)cell.z * 83492791u) & mask;
+    }
+};
+
+/*
+    实体 (生物、掉落物、下落的方块等) 的存储与物理
+    数据按结构体数组 (SoA) 存放: 同一属性连续排列, 积分等逐属性的循环可以被编译器向量化
+    位置为包围盒底面中心, 包围盒为 [x - halfWidth, x + halfWidth] x [y, y + height] x [z - halfWidth, z + halfWidth]
+    每个模拟步: 积分速度 -> 与方块扫掠碰撞 (见 Collision.hpp) -> 空间哈希找出互相重叠的实体并给它们分开的速度
+    在地面上静止一段时间的实体进入休眠, 不再参与计算, 直到附近的方块被修改 (wakeInBox) 或受到推挤
+    下落的方块 (block 不为空气) 不参与实体间的分离, 落地后由 World 放回方块网格
+*/
+class EntitySystem {
+public:
+    const glm::vec3 gravity = glm::vec3(0.0f, -32.0f, 0.0f);
+    const float airResistance = 0.98f;       // 每步的空气阻力 (与玩家一致)
+    const float groundFriction = 0.6f;       // 在地面上时每步水平速度的保留比例
+    const float separationSpeed = 4.0f;      // 重叠的实体每格重叠深度获得的分离速度
+    const float sleepSpeed = 0.05f;          // 低于此速度视为静止
+    static const int sleepTicks = 30;        // 连续静止多少步后休眠
+    static constexpr float maxEntitySize = 2.0f; // 实体包围盒的最大边长, 也是空间哈希的格子大小
+
+    // 结构体数组
+    std::vector<float> posX, posY, posZ;
+    std::vector<float> prevX, prevY, prevZ;  // 上一步的位置, 绘制时在两步之间插值
+    std::vector<float> velX, velY, velZ;
+    std::vector<float> halfWidth, height;
+    std::vector<uint8_t> onGround;
+    std::vector<uint16_t> restingTicks;      // 连续静止的步数, 达到 sleepTicks 后休眠
+    std::vector<uint32_t> ids;               // 稳定的实体编号 (下标会因删除而变化)
+    std::vector<uint8_t> block;              // 下落的方块实体代表的方块类型 (BlockType), 其他实体为空气
+
+    // 统计 (供调试界面和 worldtool 显示)
+    int lastAwake = 0;                       // 上一步参与计算的实体数
+    int lastContacts = 0;                    // 上一步互相重叠的实体对数
+
+    EntitySystem() : hash(maxEntitySize) {}
+
+    int size() const {
+        return (int)posX.size();
+    }
+
+    // 添加实体, 返回其编号
+    uint32_t spawn(const glm::vec3& position, const glm::vec3& velocity, float width, float entityHeight, uint8_t blockType = 0) {
+        posX.push_back(position.x); posY.push_back(position.y); posZ.push_back(position.z);
+        prevX.push_back(position.x); prevY.push_back(position.y); prevZ.push_back(position.z);
+        velX.push_back(velocity.x); velY.push_back(velocity.y); velZ.push_back(velocity.z);
+        halfWidth.push_back(std::min(width, maxEntitySize) * 0.5f);
+        height.push_back(std::min(entityHeight, maxEntitySize));
+        onGround.push_back(0);
+        restingTicks.push_back(0);
+        ids.push_back(nextId);
+        block.push_back(blockType);
+        return nextId++;
+    }
+
+    // 删除下标为 index 的实体 (与最后一个交换后弹出)
+    void remove(int index) {
+        int last = size() - 1;
+        for (std::vector<float>* column : { &posX, &posY, &posZ, &prevX, &prevY, &prevZ, &velX, &velY, &velZ, &halfWidth, &height }) {
+            (*column)[index] = (*column)[last];
+            column->pop_back();
+        }
+        onGround[index] = onGround[last]; onGround.pop_back();
+        restingTicks[index] = restingTicks[last]; restingTicks.pop_back();
+        ids[index] = ids[last]; ids.pop_back();
+        block[index] = block[last]; block.pop_back();
+    }
+
+    glm::vec3 getMinBound(int i) const {
+        return glm::vec3(posX[i] - halfWidth[i], posY[i], posZ[i] - halfWidth[i]);
+    }
+
+    glm::vec3 getMaxBound(int i) const {
+        return glm::vec3(posX[i] + halfWidth[i], posY[i] + height[i], posZ[i] + halfWidth[i]);
+    }
+
+    // 在上一步与当前步之间插值的包围盒底面中心 (alpha 见 Player::update)
+    glm::vec3 getRenderPosition(int i, float alpha) const {
+        return glm::mix(glm::vec3(prevX[i], prevY[i], prevZ[i]), glm::vec3(posX[i], posY[i], posZ[i]), alpha);
+    }
+
+    bool isAsleep(int i) const {
+        return restingTicks[i] >= sleepTicks;
+    }
+
+    // 唤醒包围盒与 [minBound, maxBound] 重叠或相邻的实体 (方块被修改时调用)
+    void wakeInBox(const glm::vec3& minBound, const glm::vec3& maxBound) {
+        for (int i = 0; i < size(); ++i) {
+            if (posX[i] + halfWidth[i] >= minBound.x - 1.0f && posX[i] - halfWidth[i] <= maxBound.x + 1.0f &&
+                posY[i] + height[i] >= minBound.y - 1.0f && posY[i] <= maxBound.y + 1.0f &&
+                posZ[i] + halfWidth[i] >= minBound.z - 1.0f && posZ[i] - halfWidth[i] <= maxBound.z + 1.0f) {
+                restingTicks[i] = 0;
+            }
+        }
+    }
+
+    // 推进一个模拟步; isSolid(x, y, z) 返回格子是否阻挡移动
+    template <typename IsSolid>
+    void tick(float dt, IsSolid&& isSolid) {
+        integrate(dt);
+        collide(dt, isSolid);
+        separate();
+    }
+
+    // 速度积分: 重力与阻力, 地面摩擦 (休眠的实体速度为零, 不影响结果)
+    void integrate(float dt) {
+        const int count = size();
+        float* vx = velX.data();
+        float* vy = velY.data();
+        float* vz = velZ.data();
+        const uint8_t* ground = onGround.data();
+        const float gy = gravity.y * dt;
+        for (int i = 0; i < count; ++i) {
+            vy[i] = (vy[i] + gy) * airResistance;
+        }
+        for (int i = 0; i < count; ++i) {
+            float friction = ground[i] ? groundFriction : 1.0f;
+            vx[i] *= friction;
+            vz[i] *= friction;
+        }
+    }
+
+    // 与方块的扫掠碰撞, 更新位置、速度和着地状态; 统计连续静止的步数
+    template <typename IsSolid>
+    void collide(float dt, IsSolid&& isSolid) {
+        prevX = posX;
+        prevY = posY;
+        prevZ = posZ;
+        int awake = 0;
+        for (int i = 0; i < size(); ++i) {
+            if (isAsleep(i)) {
+                velX[i] = velY[i] = velZ[i] = 0.0f;
+                continue;
+            }
+            awake++;
+            glm::vec3 motion(velX[i] * dt, velY[i] * dt, velZ[i] * dt);
+            SweepResult result = sweepBox(getMinBound(i), getMaxBound(i), motion, isSolid);
+            posX[i] += result.motion.x;
+            posY[i] += result.motion.y;
+            posZ[i] += result.motion.z;
+            if (result.normal.x != 0) velX[i] = 0.0f;
+            if (result.normal.z != 0) velZ[i] = 0.0f;
+            if (result.normal.y != 0) velY[i] = 0.0f;
+            onGround[i] = result.normal.y == 1;
+
+            bool resting = onGround[i] && std::abs(velX[i]) < sleepSpeed && std::abs(velZ[i]) < sleepSpeed;
+            restingTicks[i] = resting ? std::min(restingTicks[i] + 1, sleepTicks) : 0;
+        }
+        lastAwake = awake;
+    }
+
+    // 宽相位 + 窄相位: 互相重叠的实体沿重叠较浅的水平轴获得相反的分离速度, 下一步由扫掠碰撞移动, 不会被推进方块
+    void separate() {
+        const int count = size();
+        centerY.resize(count);
+        for (int i = 0; i < count; ++i) {
+            centerY[i] = posY[i] + height[i] * 0.5f;
+        }
+        hash.build(posX.data(), centerY.data(), posZ.data(), count);
+        int contacts = 0;
+        for (int i = 0; i < count; ++i) {
+            if (isAsleep(i)) continue; // 休眠实体与醒着的实体的接触由后者处理
+            hash.forEachNear(posX[i], centerY[i], posZ[i], [&](int j) {
+                if (j == i || (j < i && !isAsleep(j))) return; // 两个醒着的实体只处理一次
+                if (block[i] != 0 || block[j] != 0) return;
+                float overlapX = halfWidth[i] + halfWidth[j] - std::abs(posX[i] - posX[j]);
+                float overlapZ = halfWidth[i] + halfWidth[j] - std::abs(posZ[i] - posZ[j]);
+                float overlapY = std::min(posY[i] + height[i], posY[j] + height[j]) - std::max(posY[i], posY[j]);
+                if (overlapX <= 0.0f || overlapZ <= 0.0f || overlapY <= 0.0f) return;
+                contacts++;
+                restingTicks[i] = restingTicks[j] = 0;
+                if (overlapX < overlapZ) {
+                    float push = overlapX * separationSpeed * (posX[i] < posX[j] || (posX[i] == posX[j] && i < j) ? -1.0f : 1.0f);
+                    velX[i] += push;
+                    velX[j] -= push;
+                } else {
+                    float push = overlapZ * separationSpeed * (posZ[i] < posZ[j] || (posZ[i] == posZ[j] && i < j) ? -1.0f : 1.0f);
+                    velZ[i] += push;
+                    velZ[j] -= push;
+                }
+            });
+        }
+        lastContacts = contacts;
+    }
+
+    // 对包围盒与 [minBound, maxBound] 重叠的每个实体调用 visit(index) (使用上一步建立的空间哈希)
+    template <typename Visit>
+    void queryBox(const glm::vec3& minBound, const glm::vec3& maxBound, Visit&& visit) const {
+        if ((int)centerY.size() != size()) return;
+        glm::vec3 center = (minBound + maxBound) * 0.5f;
+        glm::vec3 extent = maxBound - minBound;
+        if (std::max(extent.x, std::max(extent.y, extent.z)) > maxEntitySize) {
+            // 查询范围大于格子时直接遍历全部实体
+            for (int i = 0; i < size(); ++i) {
+                if (overlaps(i, minBound, maxBound)) visit(i);
+            }
+            return;
+        }
+        hash.forEachNear(center.x, center.y, center.z, [&](int i) {
+            if (overlaps(i, minBound, maxBound)) visit(i);
+        });
+    }
+
+private:
+    uint32_t nextId = 1;
+    SpatialHash hash;
+    std::vector<float> centerY;   // 包围盒中心的 y, 建立空间哈希用
+
+    bool overlaps(int i, const glm::vec3& minBound, const glm::vec3& maxBound) const {
+        glm::vec3 lo = getMinBound(i), hi = getMaxBound(i);
+        return lo.x < maxBound.x && hi.x > minBound.x && lo.y < maxBound.y && hi.y > minBound.y && lo.z < maxBound.z && hi.z > minBound.z;
+    }
+};
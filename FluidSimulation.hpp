@@ -0,0 +1,226 @@
+#pragma once
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <glm/glm.hpp>
+#include "Block.hpp"
+#include "Chunk.hpp"
+#include "ThreadPool.hpp"
+
+/*
+    水流元胞自动机: 只处理活跃格子 (自身或相邻格子上一步发生了变化的格子), 开销与流动的水量成正比, 与世界大小无关
+    规则: 水源保持不变; 上方是水的格子成为 7 级水流 (下落); 否则取水平相邻且落在实心方块或水源上的水的最高水位减一, 为 0 时变为空气
+    同步更新: 一步内所有格子都按上一步的方块数据计算, 模拟本身不写方块数据, 变化由主线程应用 (游戏中经由存档的 setBlock, 与自动保存的快照互斥)
+    因此各区块在线程池中并行计算而无需加锁, 工作线程只读方块数据, 只写本区块的流体状态; 跨区块的激活先写入本区块的发件箱, 由主线程合并
+    调用 step 前由主线程解压涉及的区块; 周围区块尚未构建网格 (canStep 返回 false) 的区块保持活跃, 留到以后再算
+*/
+class FluidSimulation {
+public:
+    // 一次变化: 主线程据此保存、重建网格等
+    struct Change {
+        int x, y, z;
+        BlockType type;
+    };
+
+    // 统计 (供调试界面和 worldtool 显示)
+    int lastActiveCells = 0;      // 上一步处理的活跃格子数
+    int lastActiveChunks = 0;     // 上一步处理的区块数
+    int lastChanged = 0;          // 上一步变化的格子数
+    double lastStepMs = 0.0;
+    long long totalChanged = 0;
+
+    FluidSimulation(ChunkGrid& grid, int threadCount) : grid(grid), pool(threadCount), chunks(grid.chunks.size()) {}
+
+    // 激活格子及其相邻的 6 个格子 (主线程, 方块被修改时调用)
+    void activate(int x, int y, int z) {
+        activateCell(x, y, z);
+        for (const auto& dir : neighborDirs) {
+            activateCell(x + dir[0], y + dir[1], z + dir[2]);
+        }
+    }
+
+    int threadCount() const {
+        return pool.threadCount();
+    }
+
+    // 活跃的格子数 (等待下一步处理)
+    int activeCount() const {
+        int count = 0;
+        for (int index : activeChunks) {
+            count += (int)chunks[index].active.size();
+        }
+        return count;
+    }
+
+    /*
+        推进一步 (主线程), 变化的格子追加到 changes; 方块数据不变, 调用方须在下一步之前把 changes 写入方块数据
+        canStep(chunk) 返回该区块此时是否可以修改 (如周围区块都已构建网格)
+    */
+    void step(std::vector<Change>& changes, const std::function<bool(const Chunk&)>& canStep) {
+        auto start = std::chrono::steady_clock::now();
+
+        // 本步处理的区块; 其余的活跃区块原样保留
+        std::vector<int> stepping, waiting;
+        int activeCells = 0;
+        for (int index : activeChunks) {
+            const Chunk& chunk = grid.chunks[index];
+            if (canStep(chunk)) {
+                stepping.push_back(index);
+                activeCells += (int)chunks[index].active.size();
+                grid.unpackAround(chunk.cx, chunk.cz);
+            } else {
+                waiting.push_back(index);
+            }
+        }
+        activeChunks.swap(waiting);
+        for (int index : activeChunks) {
+            chunks[index].listed = true;
+        }
+        for (int index : stepping) {
+            chunks[index].listed = false;
+        }
+
+        // 各区块并行计算; 只有一个区块时直接在主线程中计算
+        if (stepping.size() == 1) {
+            stepChunk(stepping[0]);
+        } else {
+            for (int index : stepping) {
+                pool.submit({ 0.0f, index, [this, index]() { stepChunk(index); }, nullptr });
+            }
+            pool.waitIdle();
+        }
+
+        // 合并结果: 区块内的激活成为该区块下一步的活跃格子 (queued 已在 stepChunk 中设置);
+        // 全部交换完之后再分发跨区块的激活, 否则可能写进尚未交换的区块的 active 而被覆盖
+        int changed = 0;
+        for (int index : stepping) {
+            ChunkFluid& fluid = chunks[index];
+            fluid.active.swap(fluid.next);
+            if (!fluid.active.empty()) {
+                fluid.listed = true;
+                activeChunks.push_back(index);
+            }
+        }
+        for (int index : stepping) {
+            ChunkFluid& fluid = chunks[index];
+            for (const glm::ivec3& cell : fluid.outbox) {
+                activateCell(cell.x, cell.y, cell.z);
+            }
+            fluid.outbox.clear();
+            changes.insert(changes.end(), fluid.changes.begin(), fluid.changes.end());
+            changed += (int)fluid.changes.size();
+            fluid.changes.clear();
+        }
+
+        lastActiveCells = activeCells;
+        lastActiveChunks = (int)stepping.size();
+        lastChanged = changed;
+        totalChanged += changed;
+        lastStepMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // 格子按规则的下一个状态 (只读取方块数据, 调用方保证涉及的区块已解压)
+    BlockType nextState(int x, int y, int z) const {
+        BlockType type = grid.getResidentBlock(x, y, z);
+        if (type == WATER_BLOCK || isSolidBlock(type)) return type;
+        if (y + 1 < grid.worldHeight && isWater(grid.getResidentBlock(x, y + 1, z))) return WATER_FLOW_7;
+        int level = 0;
+        for (int dir = 0; dir < 4; ++dir) {
+            int nx = x + neighborDirs[dir][0], nz = z + neighborDirs[dir][2];
+            int neighborLevel = waterLevel(grid.getResidentBlock(nx, y, nz));
+            // 只有落在实心方块或水源上的水向两侧扩散, 下方悬空或是水流的水只向下流
+            if (neighborLevel > 0 && (y == 0 || isSupport(grid.getResidentBlock(nx, y - 1, nz)))) {
+                level = std::max(level, neighborLevel - 1);
+            }
+        }
+        return flowingWater(level);
+    }
+
+private:
+    static bool isSupport(BlockType type) {
+        return type == WATER_BLOCK || isSolidBlock(type);
+    }
+
+    // 水平方向在前, 上下在后 (nextState 只用前 4 个)
+    static constexpr int neighborDirs[6][3] = {
+        { 1, 0, 0 }, { -1, 0, 0 }, { 0, 0, 1 }, { 0, 0, -1 }, { 0, 1, 0 }, { 0, -1, 0 }
+    };
+
+    // 每个区块的流体状态; queued 在区块第一次有活跃格子时分配
+    struct ChunkFluid {
+        std::vector<int> active;              // 本步要处理的格子 (区块内下标)
+        std::vector<int> next;                // 本步激活的区块内格子
+        std::vector<uint8_t> queued;          // 格子是否已在 active 或 next 中
+        std::vector<glm::ivec3> outbox;       // 本步激活的其他区块的格子 (世界坐标)
+        std::vector<Change> changes;          // 本步变化的格子
+        bool listed = false;                  // 是否在 activeChunks 中
+    };
+
+    ChunkGrid& grid;
+    ThreadPool pool;
+    std::vector<ChunkFluid> chunks;
+    std::vector<int> activeChunks;            // 有活跃格子的区块
+
+    int chunkIndexOf(int x, int z) const {
+        return (x / CHUNK_SIZE) * grid.chunksZ + z / CHUNK_SIZE;
+    }
+
+    void activateCell(int x, int y, int z) {
+        if (!grid.isInsideWorld(x, y, z)) return;
+        queueCell(chunkIndexOf(x, z), ChunkGrid::blockIndex(x % CHUNK_SIZE, y, z % CHUNK_SIZE));
+    }
+
+    // 把区块内的格子加入活跃集合 (主线程)
+    void queueCell(int index, int cell) {
+        ChunkFluid& fluid = chunks[index];
+        if (fluid.queued.empty()) fluid.queued.resize(CHUNK_SIZE * CHUNK_SIZE * grid.worldHeight, 0);
+        if (fluid.queued[cell]) return;
+        fluid.queued[cell] = 1;
+        fluid.active.push_back(cell);
+        if (!fluid.listed) {
+            fluid.listed = true;
+            activeChunks.push_back(index);
+        }
+    }
+
+    // 计算一个区块的活跃格子的下一个状态 (工作线程, 只读方块数据, 只写本区块的流体状态)
+    void stepChunk(int index) {
+        ChunkFluid& fluid = chunks[index];
+        const Chunk& chunk = grid.chunks[index];
+        const int layerCells = CHUNK_SIZE * CHUNK_SIZE;
+        int x0 = chunk.cx * CHUNK_SIZE, z0 = chunk.cz * CHUNK_SIZE;
+        for (int cell : fluid.active) {
+            fluid.queued[cell] = 0;
+        }
+        for (int cell : fluid.active) {
+            int y = cell / layerCells, lz = (cell / CHUNK_SIZE) % CHUNK_SIZE, lx = cell % CHUNK_SIZE;
+            int x = x0 + lx, z = z0 + lz;
+            BlockType type = static_cast<BlockType>(chunk.blocks[cell]);
+            BlockType next = nextState(x, y, z);
+            if (next == type) continue;
+            fluid.changes.push_back({ x, y, z, next });
+
+            // 变化的格子及其相邻格子下一步重新计算
+            for (int dir = -1; dir < 6; ++dir) {
+                int nx = x, ny = y, nz = z;
+                if (dir >= 0) {
+                    nx += neighborDirs[dir][0];
+                    ny += neighborDirs[dir][1];
+                    nz += neighborDirs[dir][2];
+                }
+                if (!grid.isInsideWorld(nx, ny, nz)) continue;
+                if (nx < x0 || nx >= x0 + CHUNK_SIZE || nz < z0 || nz >= z0 + CHUNK_SIZE) {
+                    fluid.outbox.push_back(glm::ivec3(nx, ny, nz));
+                    continue;
+                }
+                int neighborCell = ChunkGrid::blockIndex(nx - x0, ny, nz - z0);
+                if (!fluid.queued[neighborCell]) {
+                    fluid.queued[neighborCell] = 1;
+                    fluid.next.push_back(neighborCell);
+                }
+            }
+        }
+        fluid.active.clear();
+    }
+};
@@ -29,6 +29,8 @@ public:
         slots[6] = BlockType::GLASS_BLOCK; // 第七个槽位放置玻璃方块
         slots[7] = BlockType::OAK_PLANKS; // 第八个槽位放置橡木板方块
         slots[8] = BlockType::STONE_BRICKS; // 第九个槽位放置石砖方块
+        slots[9] = BlockType::WATER_BLOCK; // 第十个槽位放置水源
+        slots[10] = BlockType::GLOWSTONE; // 第十一个槽位放置发光方块
         
         createTextureViews(textureManager);
         
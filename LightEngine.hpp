@@ -0,0 +1,320 @@
+#pragma once
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include <glm/glm.hpp>
+#include "Block.hpp"
+#include "Chunk.hpp"
+
+/*
+    逐方块光照: 每个格子一个字节, 高 4 位为天空光, 低 4 位为方块光 (0..MAX_LIGHT), 存放在 Chunk::light 中
+    光照每经过一格减 1, 再减去所进入方块的 lightOpacity; 天空光竖直向下穿过不衰减的方块时保持最高等级
+    - 构建网格时 (工作线程) computeChunk 在 3x3 区块范围内广度优先扩散, 得到中心区块的光照;
+      光照最多传播 MAX_LIGHT 格, 不超过一个区块, 因此只读取这 9 个区块的方块数据, 不读写其他区块的光照
+    - 编辑方块时 (主线程) update 用移除队列和添加队列增量更新: 先清除依赖旧光源的格子, 再从保留下来的边界重新扩散,
+      只访问受影响的格子; 只修改已构建网格的区块 (canEditBlock 保证编辑点周围 3x3 区块都已构建), 其余区块构建网格时自己计算
+    光照烘焙进顶点 (见 World::buildChunkMesh), 昼夜变化仍只是着色器的 uniform
+*/
+class LightEngine {
+public:
+    // 统计 (供调试界面和 worldtool 显示)
+    int lastUpdatedCells = 0;     // 上一次编辑写入光照的次数 (先清除后恢复的格子计两次)
+    double lastUpdateMs = 0.0;    // 上一次编辑更新光照的耗时
+    double maxUpdateMs = 0.0;
+    long long updates = 0;
+    double totalUpdateMs = 0.0;
+
+    // 带一圈邻居的光照 (PADDED_SIZE x worldHeight x PADDED_SIZE), 供构建网格时查询方块各个面外侧格子的光照
+    static const int PADDED_SIZE = CHUNK_SIZE + 2;
+    static const uint8_t FULL_SKY = MAX_LIGHT << 4; // 世界外 (以及光照未知的区块) 视为露天
+
+    explicit LightEngine(ChunkGrid& grid) : grid(grid), remeshMarks(grid.chunks.size(), 0) {}
+
+    static int skyLight(uint8_t light) {
+        return light >> 4;
+    }
+
+    static int blockLight(uint8_t light) {
+        return light & 0xF;
+    }
+
+    static int paddedIndex(int px, int y, int pz) {
+        return (y * PADDED_SIZE + pz) * PADDED_SIZE + px;
+    }
+
+    // 亮度为 level 的格子传给相邻的 type 方块的亮度, skyDown 表示天空光竖直向下传播
+    static int propagate(int level, BlockType type, bool skyDown) {
+        int opacity = lightOpacity(type);
+        if (opacity >= MAX_LIGHT) return 0;
+        if (skyDown && level == MAX_LIGHT && opacity == 0) return MAX_LIGHT;
+        return std::max(0, level - 1 - opacity);
+    }
+
+    // 格子自身的光源: 方块光为发光方块的亮度, 天空光为世界顶层接收的阳光
+    int sourceLevel(int y, BlockType type, bool sky) const {
+        if (!sky) return lightEmission(type);
+        return y == grid.worldHeight - 1 ? propagate(MAX_LIGHT, type, true) : 0;
+    }
+
+    /*
+        计算区块的光照 (工作线程, 调用前已解压 3x3 区块): 写入 chunk.light, 并输出带一圈邻居的光照 padded
+        世界外的格子视为不透光, 与增量更新一致
+    */
+    void computeChunk(Chunk& chunk, std::vector<uint8_t>& padded) const {
+        const int size = 3 * CHUNK_SIZE, height = grid.worldHeight;
+        const int layerCells = size * size;
+        int x0 = (chunk.cx - 1) * CHUNK_SIZE, z0 = (chunk.cz - 1) * CHUNK_SIZE;
+
+        std::vector<uint8_t> blocks(layerCells * height);
+        for (int y = 0; y < height; ++y) {
+            for (int z = 0; z < size; ++z) {
+                for (int x = 0; x < size; ++x) {
+                    bool inside = grid.isInsideWorld(x0 + x, y, z0 + z);
+                    blocks[(y * size + z) * size + x] = inside ? grid.getResidentBlock(x0 + x, y, z0 + z) : STONE_BLOCK;
+                }
+            }
+        }
+
+        // 两个通道分别扩散: 种子为阳光直射的格子 (从世界顶部向下) 和发光方块
+        std::vector<uint8_t> levels[2];
+        std::vector<int> queue;
+        for (int channel = 0; channel < 2; ++channel) {
+            bool sky = channel == 0;
+            std::vector<uint8_t>& level = levels[channel];
+            level.assign(blocks.size(), 0);
+            queue.clear();
+            if (sky) {
+                // 阳光直射的格子中, 只有水平相邻格子不被直射的才需要向两侧扩散
+                std::vector<int> sunlitFrom(layerCells, height); // 每列被阳光直射的最低高度
+                for (int column = 0; column < layerCells; ++column) {
+                    int current = MAX_LIGHT;
+                    for (int y = height - 1; y >= 0; --y) {
+                        int index = y * layerCells + column;
+                        current = propagate(current, static_cast<BlockType>(blocks[index]), true);
+                        if (current == 0) break;
+                        level[index] = current;
+                        if (current == MAX_LIGHT) sunlitFrom[column] = y;
+                        else queue.push_back(index);
+                    }
+                }
+                for (int column = 0; column < layerCells; ++column) {
+                    int x = column % size, z = column / size;
+                    int lowestNeighbor = 0;
+                    for (int dir = 0; dir < 4; ++dir) {
+                        int nx = x + neighborDirs[dir][0], nz = z + neighborDirs[dir][2];
+                        if (nx < 0 || nx >= size || nz < 0 || nz >= size) continue;
+                        lowestNeighbor = std::max(lowestNeighbor, sunlitFrom[nz * size + nx]);
+                    }
+                    // 高度低于 lowestNeighbor 的格子旁边有不被直射的格子; 最低的直射格子还要向下扩散
+                    for (int y = sunlitFrom[column]; y < std::min(height, lowestNeighbor); ++y) {
+                        queue.push_back(y * layerCells + column);
+                    }
+                    if (sunlitFrom[column] < height) queue.push_back(sunlitFrom[column] * layerCells + column);
+                }
+            } else {
+                for (int index = 0; index < (int)blocks.size(); ++index) {
+                    int emission = lightEmission(static_cast<BlockType>(blocks[index]));
+                    if (emission > 0) {
+                        level[index] = emission;
+                        queue.push_back(index);
+                    }
+                }
+            }
+
+            for (size_t head = 0; head < queue.size(); ++head) {
+                int index = queue[head];
+                int current = level[index];
+                if (current <= 1) continue;
+                int x = index % size, z = (index / size) % size, y = index / layerCells;
+                for (int dir = 0; dir < 6; ++dir) {
+                    int nx = x + neighborDirs[dir][0], ny = y + neighborDirs[dir][1], nz = z + neighborDirs[dir][2];
+                    if (nx < 0 || nx >= size || ny < 0 || ny >= height || nz < 0 || nz >= size) continue;
+                    int neighbor = (ny * size + nz) * size + nx;
+                    int candidate = propagate(current, static_cast<BlockType>(blocks[neighbor]), sky && dir == DIR_DOWN);
+                    if (candidate > level[neighbor]) {
+                        level[neighbor] = candidate;
+                        queue.push_back(neighbor);
+                    }
+                }
+            }
+        }
+
+        chunk.light.resize(CHUNK_SIZE * CHUNK_SIZE * height);
+        padded.resize(PADDED_SIZE * PADDED_SIZE * height);
+        for (int y = 0; y < height; ++y) {
+            for (int pz = 0; pz < PADDED_SIZE; ++pz) {
+                for (int px = 0; px < PADDED_SIZE; ++px) {
+                    int x = CHUNK_SIZE - 1 + px, z = CHUNK_SIZE - 1 + pz; // 3x3 范围内的坐标
+                    int index = (y * size + z) * size + x;
+                    uint8_t light = (uint8_t)(levels[0][index] << 4 | levels[1][index]);
+                    if (!grid.isInsideWorld(x0 + x, y, z0 + z)) light = FULL_SKY;
+                    padded[paddedIndex(px, y, pz)] = light;
+                    if (px >= 1 && px <= CHUNK_SIZE && pz >= 1 && pz <= CHUNK_SIZE) {
+                        chunk.light[ChunkGrid::blockIndex(px - 1, y, pz - 1)] = light;
+                    }
+                }
+            }
+        }
+    }
+
+    /*
+        从各区块已保存的光照拼出带一圈邻居的光照 (主线程, 编辑后重建网格时使用)
+        光照尚未计算的相邻区块视为露天, 它们构建网格时会自己计算
+    */
+    void gatherPadded(const Chunk& chunk, std::vector<uint8_t>& padded) const {
+        padded.resize(PADDED_SIZE * PADDED_SIZE * grid.worldHeight);
+        int x0 = chunk.cx * CHUNK_SIZE - 1, z0 = chunk.cz * CHUNK_SIZE - 1;
+        for (int y = 0; y < grid.worldHeight; ++y) {
+            for (int pz = 0; pz < PADDED_SIZE; ++pz) {
+                for (int px = 0; px < PADDED_SIZE; ++px) {
+                    const uint8_t* light = lightCell(x0 + px, y, z0 + pz);
+                    padded[paddedIndex(px, y, pz)] = light ? *light : FULL_SKY;
+                }
+            }
+        }
+    }
+
+    // 某个格子的光照 (主线程), 未知时视为露天
+    uint8_t lightAt(int x, int y, int z) const {
+        if (y >= grid.worldHeight) return FULL_SKY;
+        const uint8_t* light = lightCell(x, y, z);
+        return light ? *light : FULL_SKY;
+    }
+
+    /*
+        方块 (x, y, z) 被修改后增量更新光照 (主线程, 方块数据已写入)
+        光照改变的格子所在的区块 (格子位于边界时还有相邻区块) 追加到 remesh, 不重复
+    */
+    void update(int x, int y, int z, std::vector<glm::ivec2>& remesh) {
+        if (!lightCell(x, y, z)) return;
+        auto start = std::chrono::steady_clock::now();
+        changedCells = 0;
+        for (int channel = 0; channel < 2; ++channel) {
+            updateChannel(x, y, z, channel == 0, remesh);
+        }
+        for (const glm::ivec2& chunk : remesh) {
+            remeshMarks[chunk.x * grid.chunksZ + chunk.y] = 0;
+        }
+
+        lastUpdatedCells = changedCells;
+        lastUpdateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        maxUpdateMs = std::max(maxUpdateMs, lastUpdateMs);
+        totalUpdateMs += lastUpdateMs;
+        updates++;
+    }
+
+private:
+    // 水平方向在前, 然后向上、向下
+    static const int DIR_DOWN = 5;
+    static constexpr int neighborDirs[6][3] = {
+        { 1, 0, 0 }, { -1, 0, 0 }, { 0, 0, 1 }, { 0, 0, -1 }, { 0, 1, 0 }, { 0, -1, 0 }
+    };
+
+    struct LightNode {
+        int x, y, z;
+        int level;
+    };
+
+    ChunkGrid& grid;
+    std::vector<LightNode> removeQueue, addQueue, sources; // 复用, 避免每次编辑分配
+    std::vector<char> remeshMarks;                          // 区块是否已在本次的 remesh 中
+    int changedCells = 0;
+
+    // 格子的光照; 世界外或所在区块的光照不可修改 (尚未计算或正在工作线程中计算) 时为空
+    uint8_t* lightCell(int x, int y, int z) const {
+        if (!grid.isInsideWorld(x, y, z)) return nullptr;
+        Chunk& chunk = grid.chunks[(x / CHUNK_SIZE) * grid.chunksZ + z / CHUNK_SIZE];
+        if (chunk.state.load(std::memory_order_acquire) < CHUNK_MESHED || chunk.light.empty()) return nullptr;
+        return &chunk.light[ChunkGrid::blockIndex(x % CHUNK_SIZE, y, z % CHUNK_SIZE)];
+    }
+
+    static int channelLevel(uint8_t light, bool sky) {
+        return sky ? skyLight(light) : blockLight(light);
+    }
+
+    // 写入格子的一个通道; (x, z) 为格子所在的列, 用来标记需要重建网格的区块 (格子在区块边缘时包括相邻区块)
+    void setLevel(uint8_t* light, int x, int z, int level, bool sky, std::vector<glm::ivec2>& remesh) {
+        *light = sky ? (uint8_t)((*light & 0x0F) | level << 4) : (uint8_t)((*light & 0xF0) | level);
+        changedCells++;
+        int cx = x / CHUNK_SIZE, cz = z / CHUNK_SIZE, lx = x % CHUNK_SIZE, lz = z % CHUNK_SIZE;
+        markRemesh(cx, cz, remesh);
+        if (lx == 0) markRemesh(cx - 1, cz, remesh);
+        if (lx == CHUNK_SIZE - 1) markRemesh(cx + 1, cz, remesh);
+        if (lz == 0) markRemesh(cx, cz - 1, remesh);
+        if (lz == CHUNK_SIZE - 1) markRemesh(cx, cz + 1, remesh);
+    }
+
+    void markRemesh(int cx, int cz, std::vector<glm::ivec2>& remesh) {
+        if (!grid.hasChunk(cx, cz)) return;
+        char& mark = remeshMarks[cx * grid.chunksZ + cz];
+        if (mark) return;
+        mark = 1;
+        remesh.push_back(glm::ivec2(cx, cz));
+    }
+
+    void updateChannel(int x, int y, int z, bool sky, std::vector<glm::ivec2>& remesh) {
+        removeQueue.clear();
+        addQueue.clear();
+        sources.clear();
+
+        // 移除: 清除编辑点的光照, 以及所有亮度可能来自它的格子; 遇到更亮的格子说明它有别的来源, 留作重新扩散的起点
+        uint8_t* light = lightCell(x, y, z);
+        int old = channelLevel(*light, sky);
+        if (old > 0) {
+            setLevel(light, x, z, 0, sky, remesh);
+            removeQueue.push_back({ x, y, z, old });
+        }
+        sources.push_back({ x, y, z, 0 });
+        for (size_t head = 0; head < removeQueue.size(); ++head) {
+            LightNode node = removeQueue[head];
+            for (int dir = 0; dir < 6; ++dir) {
+                int nx = node.x + neighborDirs[dir][0], ny = node.y + neighborDirs[dir][1], nz = node.z + neighborDirs[dir][2];
+                uint8_t* neighbor = lightCell(nx, ny, nz);
+                if (!neighbor) continue;
+                int level = channelLevel(*neighbor, sky);
+                if (level == 0) continue;
+                bool fedByNode = level < node.level || (sky && dir == DIR_DOWN && level == MAX_LIGHT && node.level == MAX_LIGHT);
+                if (fedByNode) {
+                    setLevel(neighbor, nx, nz, 0, sky, remesh);
+                    removeQueue.push_back({ nx, ny, nz, level });
+                    sources.push_back({ nx, ny, nz, 0 });
+                } else {
+                    addQueue.push_back({ nx, ny, nz, 0 });
+                }
+            }
+        }
+
+        // 被清除的格子自身可能是光源 (发光方块、顶层的露天格子)
+        for (const LightNode& node : sources) {
+            int level = sourceLevel(node.y, grid.getBlock(node.x, node.y, node.z), sky);
+            uint8_t* cell = lightCell(node.x, node.y, node.z);
+            if (level > channelLevel(*cell, sky)) {
+                setLevel(cell, node.x, node.z, level, sky, remesh);
+                addQueue.push_back({ node.x, node.y, node.z, 0 });
+            }
+        }
+        // 编辑点变透明时, 相邻格子的光照流入
+        for (const auto& dir : neighborDirs) {
+            uint8_t* neighbor = lightCell(x + dir[0], y + dir[1], z + dir[2]);
+            if (neighbor && channelLevel(*neighbor, sky) > 0) addQueue.push_back({ x + dir[0], y + dir[1], z + dir[2], 0 });
+        }
+
+        // 添加: 从保留的边界和光源重新扩散
+        for (size_t head = 0; head < addQueue.size(); ++head) {
+            LightNode node = addQueue[head];
+            int level = channelLevel(*lightCell(node.x, node.y, node.z), sky);
+            if (level <= 1) continue;
+            for (int dir = 0; dir < 6; ++dir) {
+                int nx = node.x + neighborDirs[dir][0], ny = node.y + neighborDirs[dir][1], nz = node.z + neighborDirs[dir][2];
+                uint8_t* neighbor = lightCell(nx, ny, nz);
+                if (!neighbor) continue;
+                int candidate = propagate(level, grid.getBlock(nx, ny, nz), sky && dir == DIR_DOWN);
+                if (candidate > channelLevel(*neighbor, sky)) {
+                    setLevel(neighbor, nx, nz, candidate, sky, remesh);
+                    addQueue.push_back({ nx, ny, nz, 0 });
+                }
+            }
+        }
+    }
+};
@@ -0,0 +1,211 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <fstream>
+#include <mutex>
+#include <atomic>
+#include <filesystem>
+#include <iostream>
+#include <cstdint>
+#include <cstring>
+#include "MappedFile.hpp"
+
+/*
+    区块网格的磁盘缓存: 顶点数据按键 (区块内容、相邻区块边界和网格生成器版本的哈希) 追加保存在数据文件中,
+    每条记录的键和位置另外追加到一个小的索引文件, 启动时只需读索引, 不必扫描上百 MB 的数据文件
+    数据文件整体映射到内存, 命中时直接返回映射中的顶点指针, 上传 GPU 时不需要复制
+    本次运行中新生成的网格追加到文件末尾, 下次启动才能命中; 同一个键在一次运行中只追加一次
+    启动时若数据文件超过 maxBytes, 或一半以上是被替换的旧记录, 就压缩: 只保留每个键最新的记录,
+    仍然过大时优先保留较新的记录; 只有网格生成器版本改变时才丢弃整个文件
+    lookup 可以在多个线程中同时调用 (索引在打开后不再修改), store 内部加锁
+*/
+class MeshCache {
+public:
+    static const uint32_t fileMagic = 0x4853454D; // "MESH"
+    static const long long maxBytes = 1LL << 30;
+
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t mesherVersion;
+    };
+
+    // 数据文件中每条记录的头部, 其后是 floatCount 个 float
+    struct RecordHeader {
+        uint64_t key;
+        uint32_t floatCount;
+        uint32_t reserved;
+    };
+
+    // 索引文件中的一项
+    struct IndexEntry {
+        uint64_t key;
+        uint64_t offset;      // 记录头部在数据文件中的位置
+        uint32_t floatCount;
+        uint32_t reserved;
+    };
+
+    // 统计 (供调试界面显示)
+    std::atomic<long long> lookups{0};
+    std::atomic<long long> hits{0};
+    std::atomic<long long> stored{0};
+
+    MeshCache(const std::string& path, uint32_t mesherVersion) : path(path), indexPath(path + ".index") {
+        std::error_code error;
+        std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+        uint64_t liveBytes = 0;
+        bool valid = readIndex(mesherVersion, liveBytes);
+        if (valid && ((long long)mapping.size() > maxBytes || mapping.size() - sizeof(FileHeader) > 2 * liveBytes)) {
+            valid = compact(mesherVersion);
+        }
+        if (!valid) {
+            index.clear();
+            mapping.close();
+            FileHeader header = { fileMagic, mesherVersion };
+            std::ofstream(path, std::ios::binary | std::ios::trunc).write(reinterpret_cast<const char*>(&header), sizeof(header));
+            std::ofstream(indexPath, std::ios::binary | std::ios::trunc).write(reinterpret_cast<const char*>(&header), sizeof(header));
+        }
+        output.open(path, std::ios::binary | std::ios::app);
+        indexOutput.open(indexPath, std::ios::binary | std::ios::app);
+        outputBytes = (uint64_t)std::filesystem::file_size(path, error);
+        if (!index.empty()) {
+            std::cout << "[INFO] Mesh cache: " << index.size() << " meshes in " << path << std::endl;
+        }
+    }
+
+    // 查找网格; 命中时 vertices 指向映射的文件内容, 在 MeshCache 销毁前一直有效
+    bool lookup(uint64_t key, const float*& vertices, size_t& floatCount) {
+        lookups++;
+        auto found = index.find(key);
+        if (found == index.end()) return false;
+
+        // 核对记录头部, 防止索引与数据文件不一致 (如崩溃时只写了其中一个)
+        RecordHeader record;
+        std::memcpy(&record, mapping.data() + found->second.offset, sizeof(record));
+        if (record.key != key || record.floatCount != found->second.floatCount) return false;
+        hits++;
+        vertices = reinterpret_cast<const float*>(mapping.data() + found->second.offset + sizeof(record));
+        floatCount = record.floatCount;
+        return true;
+    }
+
+    // 追加保存新生成的网格: 先写数据再写索引, 索引中的记录一定已完整写入
+    void store(uint64_t key, const std::vector<float>& vertices) {
+        RecordHeader record = { key, (uint32_t)vertices.size(), 0 };
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!output || !indexOutput) return;
+        if (!storedKeys.insert(key).second) return; // 本次运行已经保存过 (同样的内容再次构建网格)
+        output.write(reinterpret_cast<const char*>(&record), sizeof(record));
+        output.write(reinterpret_cast<const char*>(vertices.data()), vertices.size() * sizeof(float));
+        output.flush();
+        IndexEntry entry = { key, outputBytes, record.floatCount, 0 };
+        indexOutput.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+        indexOutput.flush();
+        outputBytes += sizeof(record) + vertices.size() * sizeof(float);
+        stored++;
+    }
+
+    float hitRate() const {
+        long long total = lookups.load();
+        return total > 0 ? (float)hits.load() / total : 0.0f;
+    }
+
+private:
+    std::string path;
+    std::string indexPath;
+    MappedFile mapping;
+    std::unordered_map<uint64_t, IndexEntry> index;
+    std::mutex mutex;                    // 保护以下数据
+    std::ofstream output;
+    std::ofstream indexOutput;
+    uint64_t outputBytes = 0;            // 数据文件当前的长度
+    std::unordered_set<uint64_t> storedKeys; // 本次运行中已追加的键
+
+    static uint64_t recordBytes(const IndexEntry& entry) {
+        return sizeof(RecordHeader) + (uint64_t)entry.floatCount * sizeof(float);
+    }
+
+    // 映射数据文件并读入索引, liveBytes 为索引中仍有效的记录的总字节数; 文件不存在或版本不符时返回 false
+    bool readIndex(uint32_t mesherVersion, uint64_t& liveBytes) {
+        if (!mapping.open(path)) return false;
+        if (mapping.size() < sizeof(FileHeader)) return false;
+        FileHeader header;
+        std::memcpy(&header, mapping.data(), sizeof(header));
+        if (header.magic != fileMagic || header.mesherVersion != mesherVersion) return false;
+
+        std::ifstream file(indexPath, std::ios::binary);
+        FileHeader indexHeader;
+        if (!file.read(reinterpret_cast<char*>(&indexHeader), sizeof(indexHeader)) || indexHeader.magic != fileMagic || indexHeader.mesherVersion != mesherVersion) {
+            return false;
+        }
+        IndexEntry entry;
+        while (file.read(reinterpret_cast<char*>(&entry), sizeof(entry))) {
+            uint64_t end = entry.offset + recordBytes(entry);
+            if (entry.offset < sizeof(FileHeader) || end > mapping.size()) continue; // 数据没有写完整
+            index[entry.key] = entry;
+        }
+        liveBytes = 0;
+        for (const auto& item : index) {
+            liveBytes += recordBytes(item.second);
+        }
+        return true;
+    }
+
+    /*
+        把索引中的记录复制到新文件, 替换原来的数据文件和索引; 新文件不超过 maxBytes / 2, 放不下时优先保留较新 (偏移较大) 的记录
+        先写临时文件再改名, 中途退出时原文件不受影响; 只替换了其中一个文件时, lookup 核对记录头部会使不一致的项不命中
+    */
+    bool compact(uint32_t mesherVersion) {
+        std::vector<IndexEntry> entries;
+        for (const auto& item : index) {
+            entries.push_back(item.second);
+        }
+        std::sort(entries.begin(), entries.end(), [](const IndexEntry& a, const IndexEntry& b) { return a.offset > b.offset; });
+
+        const std::string dataTemp = path + ".tmp", indexTemp = indexPath + ".tmp";
+        const FileHeader header = { fileMagic, mesherVersion };
+        size_t before = index.size();
+        uint64_t beforeBytes = mapping.size();
+        std::vector<IndexEntry> kept;
+        {
+            std::ofstream data(dataTemp, std::ios::binary | std::ios::trunc);
+            std::ofstream indexData(indexTemp, std::ios::binary | std::ios::trunc);
+            data.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            indexData.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            uint64_t offset = sizeof(header);
+            for (const IndexEntry& entry : entries) {
+                RecordHeader record;
+                std::memcpy(&record, mapping.data() + entry.offset, sizeof(record));
+                if (record.key != entry.key || record.floatCount != entry.floatCount) continue;
+                if ((long long)(offset + recordBytes(entry)) > maxBytes / 2) continue;
+                data.write(reinterpret_cast<const char*>(mapping.data() + entry.offset), recordBytes(entry));
+                IndexEntry moved = { entry.key, offset, entry.floatCount, 0 };
+                indexData.write(reinterpret_cast<const char*>(&moved), sizeof(moved));
+                kept.push_back(moved);
+                offset += recordBytes(entry);
+            }
+            if (!data.flush() || !indexData.flush()) {
+                std::error_code error;
+                std::filesystem::remove(dataTemp, error);
+                std::filesystem::remove(indexTemp, error);
+                return false;
+            }
+        }
+
+        mapping.close(); // Windows 上被映射的文件不能被替换
+        std::error_code error;
+        std::filesystem::rename(dataTemp, path, error);
+        if (!error) std::filesystem::rename(indexTemp, indexPath, error);
+        if (error || !mapping.open(path)) return false;
+
+        index.clear();
+        for (const IndexEntry& entry : kept) {
+            index[entry.key] = entry;
+        }
+        std::cout << "[INFO] Mesh cache compacted: " << before << " -> " << index.size() << " meshes, "
+                  << beforeBytes / 1024 << " -> " << mapping.size() / 1024 << " KB" << std::endl;
+        return true;
+    }
+};
@@ -7,6 +7,7 @@
 #include "Block.hpp"
 #include "TextureManager.hpp"
 #include "DayTime.hpp"
+#include "Random.hpp"
 
 class ParticleSystem {
 private:
@@ -19,6 +20,8 @@ private:
     };
 
     std::vector<Particle> particles;
+    uint32_t randomSeed = Random::timeSeed(); // 粒子随机数种子
+    uint32_t emitCount = 0;                   // 已发射的批次数 (随机数计数器)
     GLuint VAO, VBO;
     Shader particleShader;
     TextureManager& textureManager; // 引用纹理管理器
@@ -40,17 +43,20 @@ public:
 
 
 void ParticleSystem::emit(const glm::vec3& position, BlockType blockType) {
+    const int particleCount = 10; // 每次产生10个粒子
+    float randoms[particleCount * 3];
+    Random::fillFloat01(randomSeed, Random::STREAM_PARTICLE, emitCount++ * (particleCount * 3), randoms, particleCount * 3);
     
-    for(int i = 0; i < 10; i++) { // 每次产生10个粒子
+    for(int i = 0; i < particleCount; i++) {
         Particle p;
         p.position = position;
         
         // 随机速度
-        float randomAngle = static_cast<float>(rand()) / RAND_MAX * 2.0f * 3.14159f;
-        float randomSpeed = static_cast<float>(rand()) / RAND_MAX * 2.0f + 1.0f;
+        float randomAngle = randoms[i * 3] * 2.0f * 3.14159f;
+        float randomSpeed = randoms[i * 3 + 1] * 2.0f + 1.0f;
         p.velocity = glm::vec3(
             cos(randomAngle) * randomSpeed,
-            static_cast<float>(rand()) / RAND_MAX * 2.0f + 2.0f, // 向上的速度
+            randoms[i * 3 + 2] * 2.0f + 2.0f, // 向上的速度
             sin(randomAngle) * randomSpeed
         );
         
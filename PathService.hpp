@@ -0,0 +1,458 @@
+#pragma once
+#include <vector>
+#include <queue>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <glm/glm.hpp>
+#include "Block.hpp"
+#include "Chunk.hpp"
+#include "ThreadPool.hpp"
+
+// 一次寻路请求: 起点和终点为脚所在的格子
+struct PathRequest {
+    glm::ivec3 start, goal;
+};
+
+struct PathResult {
+    bool found = false;
+    std::vector<glm::ivec3> path;   // 从起点到终点依次经过的格子 (含两端)
+    int regionsExpanded = 0;        // 区域图上展开的节点数
+    int cellsExpanded = 0;          // 格子上展开的节点数
+};
+
+/*
+    分层寻路服务 (供生物 AI 使用): 每个区块划分为若干可行走区域, 相邻区块的区域之间由边界上的移动连接
+    查询先在区域图上做 A*, 得到途经的区域 (走廊), 再只在走廊内的格子上做 A* 细化出具体路径
+    - 可站立的格子: 自身和上方一格可通过 (空气), 下方为实心方块 (生物高两格)
+    - 移动: 水平四方向, 可上一格 (需头顶有空间), 可下落至多 maxDrop 格; 上下一格以内的移动是双向的, 区域即双向移动的连通分量
+    - 图的数据 (区域、每个格子的可行移动) 在 refresh 中由主线程协调构建, 查询只读取图, 不读取方块数据,
+      因此多个查询可以在线程池中并行执行; 方块被修改时 invalidate 标记区块, 下次 refresh 只重建被标记的区块和其相邻区块的连接
+*/
+class PathService {
+public:
+    static const int maxDrop = 3;                 // 最多下落的高度
+    int maxRequestsPerTick = 256;                 // process 每次最多处理的请求数
+    int maxCellsExpanded = 100000;                // 单次格子 A* 最多展开的节点数, 超过视为找不到
+
+    // 统计 (供调试界面和 worldtool 显示)
+    int lastRebuiltChunks = 0;                    // 上一次 refresh 重建的区块数
+    double lastRefreshMs = 0.0;
+    int lastBatchRequests = 0;                    // 上一批处理的请求数
+    double lastBatchMs = 0.0;
+    long long totalPaths = 0;
+    long long totalFound = 0;
+
+    PathService(ChunkGrid& grid, int threadCount = 0) : grid(grid), pool(threadCount), graphs(grid.chunks.size()) {}
+
+    int threadCount() const {
+        return pool.threadCount();
+    }
+
+    // 提交请求, 结果在之后某次 process 中回调 (主线程)
+    void submit(const PathRequest& request, std::function<void(const PathResult&)> onDone) {
+        pending.push_back({ request, std::move(onDone) });
+    }
+
+    size_t pendingCount() const {
+        return pending.size();
+    }
+
+    // 方块 (x, *, z) 被修改: 所在区块需要重建; 位于边界时相邻区块通往该区块的移动也可能改变
+    void invalidate(int x, int z) {
+        if (x < 0 || z < 0 || x >= grid.worldWidth || z >= grid.worldDepth) return;
+        int cx = x / CHUNK_SIZE, cz = z / CHUNK_SIZE, lx = x % CHUNK_SIZE, lz = z % CHUNK_SIZE;
+        markDirty(cx, cz);
+        if (lx == 0) markDirty(cx - 1, cz);
+        if (lx == CHUNK_SIZE - 1) markDirty(cx + 1, cz);
+        if (lz == 0) markDirty(cx, cz - 1);
+        if (lz == CHUNK_SIZE - 1) markDirty(cx, cz + 1);
+    }
+
+    /*
+        每个模拟步在主线程调用: 有等待的请求时先更新图, 再在线程池中并行处理至多 maxRequestsPerTick 个请求, 然后回调
+        isReady(chunk) 返回区块的方块数据此时是否可以读取 (不会被工作线程修改)
+    */
+    void process(const std::function<bool(const Chunk&)>& isReady) {
+        if (pending.empty()) return;
+        refresh(isReady);
+
+        size_t count = std::min(pending.size(), (size_t)maxRequestsPerTick);
+        std::vector<PathRequest> requests;
+        for (size_t i = 0; i < count; ++i) {
+            requests.push_back(pending[i].request);
+        }
+        std::vector<PathResult> results;
+        findPaths(requests, results);
+        for (size_t i = 0; i < count; ++i) {
+            if (pending[i].onDone) pending[i].onDone(results[i]);
+        }
+        pending.erase(pending.begin(), pending.begin() + count);
+    }
+
+    // 构建新就绪的区块和被标记的区块的图, 释放不再就绪的区块的图, 并更新受影响区块的区域连接 (主线程)
+    void refresh(const std::function<bool(const Chunk&)>& isReady) {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<int> rebuild;
+        std::vector<char> relinkMarks(graphs.size(), 0);
+        for (int index = 0; index < (int)graphs.size(); ++index) {
+            ChunkGraph& graph = graphs[index];
+            const Chunk& chunk = grid.chunks[index];
+            bool ready = isReady(chunk);
+            if (ready && (!graph.built || graph.dirty)) {
+                rebuild.push_back(index);
+                markNeighbors(chunk, relinkMarks);
+            } else if (!ready && graph.built) {
+                graph = ChunkGraph();
+                markNeighbors(chunk, relinkMarks);
+            }
+        }
+        for (int index : rebuild) {
+            grid.unpackAround(grid.chunks[index].cx, grid.chunks[index].cz); // 构建时读取相邻区块边界上的方块
+        }
+        parallelFor(rebuild, [this](int index) { buildChunk(index); });
+
+        std::vector<int> relink;
+        for (int index = 0; index < (int)graphs.size(); ++index) {
+            if (relinkMarks[index] && graphs[index].built) relink.push_back(index);
+        }
+        parallelFor(relink, [this](int index) { linkChunk(index); });
+
+        lastRebuiltChunks = (int)rebuild.size();
+        lastRefreshMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // 在线程池中并行处理一批请求 (调用前 refresh), results[i] 为 requests[i] 的结果
+    void findPaths(const std::vector<PathRequest>& requests, std::vector<PathResult>& results) {
+        auto start = std::chrono::steady_clock::now();
+        results.assign(requests.size(), PathResult());
+        std::vector<int> indices(requests.size());
+        for (int i = 0; i < (int)requests.size(); ++i) indices[i] = i;
+        parallelFor(indices, [&](int i) { results[i] = findPath(requests[i]); });
+
+        lastBatchRequests = (int)requests.size();
+        lastBatchMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        totalPaths += requests.size();
+        for (const PathResult& result : results) {
+            if (result.found) totalFound++;
+        }
+    }
+
+    // 分层寻路: 区域图上的 A* 得到走廊, 再在走廊内的格子上做 A* (可在任意线程调用, 只读)
+    PathResult findPath(const PathRequest& request) const {
+        PathResult result;
+        glm::ivec3 start, goal;
+        if (!snapToStandable(request.start, start) || !snapToStandable(request.goal, goal)) return result;
+        std::vector<int> corridor;
+        if (!findCorridor(regionKeyAt(start), regionKeyAt(goal), glm::vec3(goal) + 0.5f, corridor, result.regionsExpanded)) return result;
+        std::sort(corridor.begin(), corridor.end());
+        result.found = findCells(start, goal, &corridor, result);
+        return result;
+    }
+
+    // 不分层, 直接在格子上做 A* (对照用)
+    PathResult findPathDirect(const PathRequest& request) const {
+        PathResult result;
+        glm::ivec3 start, goal;
+        if (!snapToStandable(request.start, start) || !snapToStandable(request.goal, goal)) return result;
+        result.found = findCells(start, goal, nullptr, result);
+        return result;
+    }
+
+    // 已构建图的区块数和区域数
+    int builtChunks() const {
+        return (int)std::count_if(graphs.begin(), graphs.end(), [](const ChunkGraph& graph) { return graph.built; });
+    }
+
+    int regionCount() const {
+        int count = 0;
+        for (const ChunkGraph& graph : graphs) count += (int)graph.regions.size();
+        return count;
+    }
+
+private:
+    static const int REGION_LIMIT = 8192;         // 区域键 = 区块下标 * REGION_LIMIT + 区块内的区域编号 (不超过区块的格子数)
+    static const int NO_MOVE = 7;                 // cellMoves 中表示该方向不能移动
+    static constexpr int horizontalDirs[4][2] = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+
+    struct Link {
+        int target;   // 目标区域的键
+        float cost;   // 两个区域中心之间的距离
+    };
+
+    struct Region {
+        glm::vec3 center = glm::vec3(0.0f);
+        int cells = 0;
+        std::vector<Link> links;
+    };
+
+    // 每个区块的图; 下标同区块的方块数据
+    struct ChunkGraph {
+        bool built = false;
+        bool dirty = false;
+        std::vector<int16_t> cellRegion;   // 格子所属的区域, 不可站立为 -1
+        std::vector<uint16_t> cellMoves;   // 每个方向 3 位: 移动的高度差 + maxDrop, 或 NO_MOVE
+        std::vector<Region> regions;
+    };
+
+    struct PendingRequest {
+        PathRequest request;
+        std::function<void(const PathResult&)> onDone;
+    };
+
+    ChunkGrid& grid;
+    ThreadPool pool;
+    std::vector<ChunkGraph> graphs;
+    std::vector<PendingRequest> pending;
+
+    void markDirty(int cx, int cz) {
+        if (grid.hasChunk(cx, cz)) graphs[cx * grid.chunksZ + cz].dirty = true;
+    }
+
+    void markNeighbors(const Chunk& chunk, std::vector<char>& marks) const {
+        marks[chunk.cx * grid.chunksZ + chunk.cz] = 1;
+        for (const auto& dir : horizontalDirs) {
+            if (grid.hasChunk(chunk.cx + dir[0], chunk.cz + dir[1])) marks[(chunk.cx + dir[0]) * grid.chunksZ + chunk.cz + dir[1]] = 1;
+        }
+    }
+
+    // 在线程池中对每个元素执行 work 并等待完成; 只有一个元素时直接在当前线程执行
+    void parallelFor(const std::vector<int>& items, const std::function<void(int)>& work) {
+        if (items.size() == 1) {
+            work(items[0]);
+            return;
+        }
+        for (int item : items) {
+            pool.submit({ 0.0f, item, [&work, item]() { work(item); }, nullptr });
+        }
+        pool.waitIdle();
+    }
+
+    static bool isPassable(BlockType type) {
+        return !isSolidBlock(type) && !isWater(type); // 不进入水
+    }
+
+    bool isStandable(int x, int y, int z) const {
+        return y >= 1 && grid.isInsideWorld(x, y, z) && isPassable(grid.getResidentBlock(x, y, z))
+            && isPassable(grid.getResidentBlock(x, y + 1, z)) && isSolidBlock(grid.getResidentBlock(x, y - 1, z));
+    }
+
+    // 从可站立的格子 (x, y, z) 向 dir 方向移动的高度差, 不能移动时为 NO_MOVE (构建时调用, 方块已解压)
+    int moveDelta(int x, int y, int z, int dir) const {
+        int nx = x + horizontalDirs[dir][0], nz = z + horizontalDirs[dir][1];
+        if (isStandable(nx, y + 1, nz) && isPassable(grid.getResidentBlock(x, y + 2, z))) return 1; // 跳上一格
+        for (int dy = 0; dy >= -maxDrop; --dy) {
+            int ty = y + dy;
+            if (!isPassable(grid.getResidentBlock(nx, ty + 1, nz)) || ty < 0) return NO_MOVE; // 下落途中被挡住
+            if (isStandable(nx, ty, nz)) return dy;
+        }
+        return NO_MOVE;
+    }
+
+    static int moveOf(uint16_t moves, int dir) {
+        return (moves >> (dir * 3)) & 7;
+    }
+
+    // 计算区块内每个格子的可行移动, 并按双向移动划分区域 (工作线程, 只写本区块的图)
+    void buildChunk(int index) {
+        ChunkGraph& graph = graphs[index];
+        const Chunk& chunk = grid.chunks[index];
+        const int cellCount = CHUNK_SIZE * CHUNK_SIZE * grid.worldHeight;
+        int x0 = chunk.cx * CHUNK_SIZE, z0 = chunk.cz * CHUNK_SIZE;
+        graph.cellRegion.assign(cellCount, -1);
+        graph.cellMoves.assign(cellCount, 0);
+        graph.regions.clear();
+
+        std::vector<int> standable;
+        for (int y = 1; y < grid.worldHeight; ++y) {
+            for (int lz = 0; lz < CHUNK_SIZE; ++lz) {
+                for (int lx = 0; lx < CHUNK_SIZE; ++lx) {
+                    if (!isStandable(x0 + lx, y, z0 + lz)) continue;
+                    int cell = ChunkGrid::blockIndex(lx, y, lz);
+                    uint16_t moves = 0;
+                    for (int dir = 0; dir < 4; ++dir) {
+                        int delta = moveDelta(x0 + lx, y, z0 + lz, dir);
+                        moves |= (uint16_t)((delta == NO_MOVE ? NO_MOVE : delta + maxDrop) << (dir * 3));
+                    }
+                    graph.cellMoves[cell] = moves;
+                    graph.cellRegion[cell] = -2; // 可站立, 尚未分配区域
+                    standable.push_back(cell);
+                }
+            }
+        }
+
+        // 区域: 区块内经由双向移动 (高度差不超过 1) 连通的格子
+        std::vector<int> queue;
+        for (int seed : standable) {
+            if (graph.cellRegion[seed] != -2) continue;
+            int16_t region = (int16_t)graph.regions.size();
+            graph.regions.emplace_back();
+            Region& info = graph.regions.back();
+            graph.cellRegion[seed] = region;
+            queue.assign(1, seed);
+            for (size_t head = 0; head < queue.size(); ++head) {
+                int cell = queue[head];
+                int lx = cell % CHUNK_SIZE, lz = (cell / CHUNK_SIZE) % CHUNK_SIZE, y = cell / (CHUNK_SIZE * CHUNK_SIZE);
+                info.center += glm::vec3(x0 + lx, y, z0 + lz) + 0.5f;
+                info.cells++;
+                for (int dir = 0; dir < 4; ++dir) {
+                    int move = moveOf(graph.cellMoves[cell], dir);
+                    if (move == NO_MOVE || move - maxDrop < -1) continue;
+                    int nx = lx + horizontalDirs[dir][0], nz = lz + horizontalDirs[dir][1];
+                    if (nx < 0 || nx >= CHUNK_SIZE || nz < 0 || nz >= CHUNK_SIZE) continue;
+                    int neighbor = ChunkGrid::blockIndex(nx, y + move - maxDrop, nz);
+                    if (graph.cellRegion[neighbor] != -2) continue;
+                    graph.cellRegion[neighbor] = region;
+                    queue.push_back(neighbor);
+                }
+            }
+            info.center /= (float)info.cells;
+        }
+        graph.built = true;
+        graph.dirty = false;
+    }
+
+    // 根据每个格子的移动连接区域 (含下落和跨区块的移动); 目标区块的图尚未构建时不连接 (工作线程, 只写本区块的图)
+    void linkChunk(int index) {
+        ChunkGraph& graph = graphs[index];
+        const Chunk& chunk = grid.chunks[index];
+        int x0 = chunk.cx * CHUNK_SIZE, z0 = chunk.cz * CHUNK_SIZE;
+        std::vector<std::vector<int>> targets(graph.regions.size());
+        for (int cell = 0; cell < (int)graph.cellRegion.size(); ++cell) {
+            int region = graph.cellRegion[cell];
+            if (region < 0) continue;
+            int lx = cell % CHUNK_SIZE, lz = (cell / CHUNK_SIZE) % CHUNK_SIZE, y = cell / (CHUNK_SIZE * CHUNK_SIZE);
+            for (int dir = 0; dir < 4; ++dir) {
+                int move = moveOf(graph.cellMoves[cell], dir);
+                if (move == NO_MOVE) continue;
+                int key = regionKeyAt(glm::ivec3(x0 + lx + horizontalDirs[dir][0], y + move - maxDrop, z0 + lz + horizontalDirs[dir][1]));
+                if (key >= 0 && key != index * REGION_LIMIT + region) targets[region].push_back(key);
+            }
+        }
+        for (size_t region = 0; region < graph.regions.size(); ++region) {
+            std::vector<int>& keys = targets[region];
+            std::sort(keys.begin(), keys.end());
+            keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+            Region& info = graph.regions[region];
+            info.links.clear();
+            for (int key : keys) {
+                info.links.push_back({ key, glm::distance(info.center, regionOf(key).center) });
+            }
+        }
+    }
+
+    // 格子所属区域的键; 世界外、区块的图尚未构建或不可站立时为 -1
+    int regionKeyAt(const glm::ivec3& cell) const {
+        if (!grid.isInsideWorld(cell.x, cell.y, cell.z)) return -1;
+        int index = (cell.x / CHUNK_SIZE) * grid.chunksZ + cell.z / CHUNK_SIZE;
+        const ChunkGraph& graph = graphs[index];
+        if (!graph.built) return -1;
+        int region = graph.cellRegion[ChunkGrid::blockIndex(cell.x % CHUNK_SIZE, cell.y, cell.z % CHUNK_SIZE)];
+        return region < 0 ? -1 : index * REGION_LIMIT + region;
+    }
+
+    const Region& regionOf(int key) const {
+        return graphs[key / REGION_LIMIT].regions[key % REGION_LIMIT];
+    }
+
+    // 请求的格子不可站立时 (如生物正在下落), 向下找至多 maxDrop 格, 再向上找一格
+    bool snapToStandable(const glm::ivec3& cell, glm::ivec3& result) const {
+        for (int dy : { 0, -1, -2, -3, 1 }) {
+            glm::ivec3 candidate = cell + glm::ivec3(0, dy, 0);
+            if (regionKeyAt(candidate) >= 0) {
+                result = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 区域图上的 A*: corridor 为从起点区域到终点区域途经的区域
+    bool findCorridor(int startKey, int goalKey, const glm::vec3& goal, std::vector<int>& corridor, int& expanded) const {
+        struct Node {
+            float g;
+            int parent;
+            bool closed;
+        };
+        std::unordered_map<int, Node> nodes;
+        using Entry = std::pair<float, int>;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+        auto heuristic = [&](int key) { return glm::distance(regionOf(key).center, goal); };
+        nodes[startKey] = { 0.0f, -1, false };
+        open.push({ heuristic(startKey), startKey });
+        while (!open.empty()) {
+            int key = open.top().second;
+            open.pop();
+            Node& node = nodes[key];
+            if (node.closed) continue;
+            node.closed = true;
+            expanded++;
+            if (key == goalKey) {
+                for (int current = key; current != -1; current = nodes[current].parent) corridor.push_back(current);
+                return true;
+            }
+            float g = node.g;
+            for (const Link& link : regionOf(key).links) {
+                auto found = nodes.find(link.target);
+                float candidate = g + link.cost;
+                if (found != nodes.end() && (found->second.closed || found->second.g <= candidate)) continue;
+                nodes[link.target] = { candidate, key, false };
+                open.push({ candidate + heuristic(link.target), link.target });
+            }
+        }
+        return false;
+    }
+
+    // 格子上的 A*, 每步代价为 1, 启发函数为水平曼哈顿距离; corridor 非空时只进入走廊内的区域 (已排序)
+    bool findCells(const glm::ivec3& start, const glm::ivec3& goal, const std::vector<int>* corridor, PathResult& result) const {
+        const int height = grid.worldHeight, depth = grid.worldDepth;
+        auto cellKey = [&](const glm::ivec3& cell) { return (cell.x * height + cell.y) * depth + cell.z; };
+        auto cellOf = [&](int key) { return glm::ivec3(key / (height * depth), (key / depth) % height, key % depth); };
+        auto heuristic = [&](const glm::ivec3& cell) { return std::abs(cell.x - goal.x) + std::abs(cell.z - goal.z); };
+
+        struct Node {
+            int g;
+            int parent;
+            bool closed;
+        };
+        std::unordered_map<int, Node> nodes;
+        using Entry = std::pair<int, int>;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+        int startKey = cellKey(start), goalKey = cellKey(goal);
+        nodes[startKey] = { 0, -1, false };
+        open.push({ heuristic(start), startKey });
+        while (!open.empty() && result.cellsExpanded < maxCellsExpanded) {
+            int key = open.top().second;
+            open.pop();
+            Node& node = nodes[key];
+            if (node.closed) continue;
+            node.closed = true;
+            result.cellsExpanded++;
+            if (key == goalKey) {
+                for (int current = key; current != -1; current = nodes[current].parent) result.path.push_back(cellOf(current));
+                std::reverse(result.path.begin(), result.path.end());
+                return true;
+            }
+            glm::ivec3 cell = cellOf(key);
+            int g = node.g;
+            const ChunkGraph& graph = graphs[(cell.x / CHUNK_SIZE) * grid.chunksZ + cell.z / CHUNK_SIZE];
+            uint16_t moves = graph.cellMoves[ChunkGrid::blockIndex(cell.x % CHUNK_SIZE, cell.y, cell.z % CHUNK_SIZE)];
+            for (int dir = 0; dir < 4; ++dir) {
+                int move = moveOf(moves, dir);
+                if (move == NO_MOVE) continue;
+                glm::ivec3 next(cell.x + horizontalDirs[dir][0], cell.y + move - maxDrop, cell.z + horizontalDirs[dir][1]);
+                int region = regionKeyAt(next);
+                if (region < 0) continue; // 目标区块的图尚未构建
+                if (corridor && !std::binary_search(corridor->begin(), corridor->end(), region)) continue;
+                int nextKey = cellKey(next);
+                auto found = nodes.find(nextKey);
+                if (found != nodes.end() && (found->second.closed || found->second.g <= g + 1)) continue;
+                nodes[nextKey] = { g + 1, key, false };
+                open.push({ g + 1 + heuristic(next), nextKey });
+            }
+        }
+        return false;
+    }
+};
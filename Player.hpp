@@ -9,7 +9,9 @@
 
 class Player {
 private:
-    glm::vec3 position;  // 摄像机位置
+    glm::vec3 position;  // 摄像机位置 (当前模拟步的结果)
+    glm::vec3 previousPosition;  // 上一个模拟步的摄像机位置
+    glm::vec3 renderPosition;    // 在两个模拟步之间插值得到的绘制位置
     glm::vec3 front;     // 摄像机前方向
     glm::vec3 up;        // 摄像机上方向
     glm::vec3 right;     // 摄像机右方向
@@ -34,12 +36,20 @@ private:
 
     bool isSpectatorMode = false; // 是否处于观察者模式
 
+    bool showDebugInfo = false; // 是否显示调试信息 (F3)
+
     const float cameraHeight = 1.62f; // 摄像机高度
     const float playerHeight = 1.8f;  // 玩家高度
     const float halfPlayerWidth = 0.3f; // 玩家宽度的一半
 
     const float mouseSensitivity = 0.03f; // 鼠标灵敏度
 
+    // 固定步长模拟: 物理以 tickRate 的固定频率推进, 与帧率无关; 绘制时在最近两步之间插值
+    static constexpr float tickRate = 60.0f;
+    static constexpr float tickDuration = 1.0f / tickRate;
+    static constexpr float maxFrameTime = 0.25f;  // 单帧最多追赶的时间, 卡顿时模拟放慢而不是一次推进过多步
+    float tickAccumulator = 0.0f;                 // 尚未模拟的时间
+
     float lastX, lastY;  // 上一帧鼠标位置
 
     // 物品栏实例
@@ -54,6 +64,8 @@ private:
 public:
     Player(glm::vec3 startPosition, World& world, int width, int height) 
         : position(startPosition) 
+        , previousPosition(startPosition)
+        , renderPosition(startPosition)
         , world(world) 
         , windowWidth(width)
         , windowHeight(height), inventory(world.textureManager) {
@@ -78,7 +90,7 @@ public:
 
     // 获取视图矩阵
     glm::mat4 getViewMatrix() const {
-        return glm::lookAt(position, position + front, up);
+        return glm::lookAt(renderPosition, renderPosition + front, up);
     }
 
     // 处理鼠标移动输入
@@ -135,6 +147,9 @@ public:
                     isSpectatorMode = !isSpectatorMode;
                     isFlying = true;
                 }
+                if (key == GLFW_KEY_F3) {
+                    showDebugInfo = !showDebugInfo;
+                }
             } else if (action == GLFW_RELEASE) {
                 keys[key] = false;
                 // 松开左 Ctrl 键
@@ -146,40 +161,35 @@ public:
         // updatePosition()
     }
 
-    // 脚底y为整数 && 脚底有方块 && 垂直速度为0 -> true
-    bool isOnGround() {
-        const float eps = 0.01f;      // 精度
-        // 脚底范围
-        glm::vec3 minBound = position + glm::vec3(-halfPlayerWidth, -cameraHeight, -halfPlayerWidth);
-        glm::vec3 maxBound = position + glm::vec3(halfPlayerWidth, -cameraHeight, halfPlayerWidth);
-        // 检查脚底y坐标是否接近整数
-        if (std::abs(minBound.y - std::round(minBound.y)) > eps) {
-            return false; 
-        }
-        
-        // 获取四个角的坐标
-        std::vector<glm::vec3> corners = {
-            glm::vec3(minBound.x, minBound.y, minBound.z),
-            glm::vec3(maxBound.x, minBound.y, minBound.z),
-            glm::vec3(minBound.x, minBound.y, maxBound.z),
-            glm::vec3(maxBound.x, minBound.y, maxBound.z)
-        };
-
-        // 检查四个角是否有方块支撑
-        for (const auto& corner : corners) {
-            int blockX = static_cast<int>(std::floor(corner.x));
-            int blockY = static_cast<int>(std::round(corner.y)) - 1; 
-            int blockZ = static_cast<int>(std::floor(corner.z));
-            if (world.getBlock(blockX, blockY, blockZ) != BlockType::BLOCK_AIR) { // 脚下有方块
-                return std::abs(velocity.y) < eps; // 检查垂直速度是否为0
-            }
-        }
+    // 玩家的碰撞包围盒
+    glm::vec3 getMinBound() const {
+        return position - glm::vec3(halfPlayerWidth, cameraHeight, halfPlayerWidth);
+    }
+    glm::vec3 getMaxBound() const {
+        return position + glm::vec3(halfPlayerWidth, playerHeight - cameraHeight, halfPlayerWidth);
+    }
 
-        return false;
+    // 包围盒向下移动一小段距离会撞到方块 (接触面法线朝上) && 没有在上升 -> true
+    bool isOnGround() {
+        const float eps = 0.01f;      // 探测距离
+        SweepResult probe = world.moveBox(getMinBound(), getMaxBound(), glm::vec3(0.0f, -eps, 0.0f));
+        return probe.normal.y == 1 && velocity.y <= 0.0f;
     }
 
 
-    // 更新玩家位置
+    // 按帧间隔推进模拟: 累积时间, 每满 tickDuration 执行一步 updatePosition 和世界的模拟步, 余下的比例用于插值绘制位置
+    void update(float frameTime) {
+        tickAccumulator += std::min(frameTime, maxFrameTime);
+        while (tickAccumulator >= tickDuration) {
+            previousPosition = position;
+            updatePosition(tickDuration);
+            world.tick(tickDuration);
+            tickAccumulator -= tickDuration;
+        }
+        renderPosition = glm::mix(previousPosition, position, getInterpolationAlpha());
+    }
+
+    // 更新玩家位置 (一个模拟步)
     void updatePosition(float deltaTime) {
         // 根据是否疾跑来决定移动速度
         float currentSpeed = isSprinting ? sprintSpeed : normalSpeed;
@@ -256,45 +266,18 @@ public:
             velocity.y = (velocity.y + gravity.y * deltaTime) * resistanceFactor;
         }
 
-        // 基于速度计算潜在的新位置
-        glm::vec3 potentialPosition = position + velocity * deltaTime;
-
         if (!isSpectatorMode) {
-            // 逐方向碰撞检测
-            glm::vec3 nextPosition = position;
-            // X方向
-            nextPosition.x = potentialPosition.x;
-            glm::vec3 minBound = nextPosition - glm::vec3(halfPlayerWidth, cameraHeight, halfPlayerWidth);
-            glm::vec3 maxBound = nextPosition + glm::vec3(halfPlayerWidth, playerHeight - cameraHeight, halfPlayerWidth);
-            if (world.isColliding(minBound, maxBound)) {
-                nextPosition.x = position.x; // 恢复原位置
-                velocity.x = 0.0f;           // 停止X方向速度
-            }
-
-            // Z方向
-            nextPosition.z = potentialPosition.z;
-            minBound = nextPosition - glm::vec3(halfPlayerWidth, cameraHeight, halfPlayerWidth);
-            maxBound = nextPosition + glm::vec3(halfPlayerWidth, playerHeight - cameraHeight, halfPlayerWidth);
-            if (world.isColliding(minBound, maxBound)) {
-                nextPosition.z = position.z; // 恢复原位置
-                velocity.z = 0.0f;           // 停止Z方向速度
+            // 扫掠碰撞: 逐方向移动到碰到的第一个方块为止, 速度再大也不会穿过方块
+            SweepResult result = world.moveBox(getMinBound(), getMaxBound(), velocity * deltaTime);
+            position += result.motion;
+            if (result.normal.x != 0) velocity.x = 0.0f; // 停止X方向速度
+            if (result.normal.z != 0) velocity.z = 0.0f; // 停止Z方向速度
+            if (result.normal.y == 1 && velocity.y < 0.0f) { // 如果正在下降并落地
+                velocity.y = 0.0f;  // 停止Y方向速度
             }
-
-            // Y方向
-            nextPosition.y = potentialPosition.y;
-            minBound = nextPosition - glm::vec3(halfPlayerWidth, cameraHeight, halfPlayerWidth);
-            maxBound = nextPosition + glm::vec3(halfPlayerWidth, playerHeight - cameraHeight, halfPlayerWidth);
-            if (world.isColliding(minBound, maxBound)) {
-                if (velocity.y < 0.0f) { // 如果正在下降
-                    velocity.y = 0.0f;  // 停止Y方向速度
-                }
-                nextPosition.y = position.y; // 恢复原位置
-            }
-            // 更新最终位置
-            position = nextPosition;
         }
         else {
-            position = potentialPosition;
+            position += velocity * deltaTime;
         }
             // std::cout << "velocity: " << velocity.x << " " << velocity.y << " " << velocity.z << std::endl;
             // std::cout << "position: " << position.x << " " << position.y << " " << position.z << std::endl;
@@ -321,20 +304,18 @@ public:
     // 处理左键点击
     void handleLeftClick() {
         glm::vec3 blockHit;
-        if (world.detectSelectedBlock(position, front, blockHit)) {
+        if (world.detectSelectedBlock(renderPosition, front, blockHit)) {
             world.updateBlock(static_cast<int>(blockHit.x), static_cast<int>(blockHit.y), static_cast<int>(blockHit.z), BlockType::BLOCK_AIR);
         }
     }
 
     // 处理右键点击
     void handRightClick() {
-        glm::vec3 blockHit;
-        if (world.findLastAirBlock(position, front, blockHit)) {
-            glm::vec3 minBound = position + glm::vec3(-halfPlayerWidth, -cameraHeight, -halfPlayerWidth);
-            glm::vec3 maxBound = position + glm::vec3(halfPlayerWidth, playerHeight - cameraHeight, halfPlayerWidth);
-            if (!world.isCollidingWith(minBound, maxBound, static_cast<int>(blockHit.x), static_cast<int>(blockHit.y), static_cast<int>(blockHit.z)))
+        glm::ivec3 placePos;
+        if (world.findPlacementBlock(renderPosition, front, placePos)) {
+            if (!world.isCollidingWith(getMinBound(), getMaxBound(), placePos.x, placePos.y, placePos.z))
             {
-                world.updateBlock(static_cast<int>(blockHit.x), static_cast<int>(blockHit.y), static_cast<int>(blockHit.z), blockInHand);
+                world.updateBlock(placePos.x, placePos.y, placePos.z, blockInHand);
             }
         }
     }
@@ -347,9 +328,19 @@ public:
         glfwSetMouseButtonCallback(window, mouseButtonCallback);
     }
 
-    // 获取摄像机位置
+    // 获取摄像机位置 (插值后的绘制位置, 与画面一致)
     glm::vec3 getCameraPosition() const {
-        return position;
+        return renderPosition;
+    }
+
+    // 当前帧位于最近两个模拟步之间的比例 (0..1), 用于插值绘制
+    float getInterpolationAlpha() const {
+        return tickAccumulator / tickDuration;
+    }
+
+    // 获取玩家速度 (用于区块预取)
+    glm::vec3 getVelocity() const {
+        return velocity;
     }
 
     // 获取摄像机前方向（光线方向）
@@ -357,6 +348,10 @@ public:
         return front;
     }
 
+    bool isDebugInfoVisible() const {
+        return showDebugInfo;
+    }
+
     void inventory_render(){
         this->inventory.render();
     }
@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <ctime>
+#include <chrono>
+
+/*
+    无状态的计数器随机数
+    随机值是 (种子, 流编号, 坐标/计数器) 的哈希, 不依赖调用顺序和全局状态,
+    任意位置的随机值都可以独立、并行地计算
+*/
+namespace Random {
+    // 随机流编号, 不同用途使用不同的流, 互不相关
+    enum Stream : uint32_t {
+        STREAM_NOISE_SEED = 1,  // 噪声种子
+        STREAM_TREE,            // 树木位置
+        STREAM_TREE_HEIGHT,     // 树木高度
+        STREAM_PARTICLE,        // 粒子
+    };
+
+    // 32位整数哈希 (lowbias32), 只用移位、异或和 32 位乘法, 便于向量化
+    inline uint32_t hash32(uint32_t x) {
+        x ^= x >> 16;
+        x *= 0x7feb352dU;
+        x ^= x >> 15;
+        x *= 0x846ca68bU;
+        x ^= x >> 16;
+        return x;
+    }
+
+    // 由种子和流编号得到基础键
+    inline uint32_t streamKey(uint32_t seed, uint32_t stream) {
+        return hash32(seed ^ hash32(stream * 0x9E3779B9U));
+    }
+
+    // 坐标 (x, y, z) 处的随机值
+    inline uint32_t at(uint32_t seed, uint32_t stream, int x, int y, int z) {
+        uint32_t h = streamKey(seed, stream);
+        h = hash32(h ^ (uint32_t)x);
+        h = hash32(h ^ (uint32_t)y);
+        return hash32(h ^ (uint32_t)z);
+    }
+
+    // 第 counter 个随机值
+    inline uint32_t at(uint32_t seed, uint32_t stream, uint32_t counter) {
+        return hash32(streamKey(seed, stream) ^ hash32(counter));
+    }
+
+    // 把 32 位随机值映射到 [0, 1)
+    inline float toFloat01(uint32_t value) {
+        return (value >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // 批量生成 [0, 1) 的浮点随机数
+    inline void fillFloat01(uint32_t seed, uint32_t stream, uint32_t counter, float* out, int count) {
+        const uint32_t key = streamKey(seed, stream);
+        for (int i = 0; i < count; ++i) {
+            out[i] = toFloat01(hash32(key ^ hash32(counter + (uint32_t)i)));
+        }
+    }
+
+    // 由当前时间生成一个随机种子
+    inline uint32_t timeSeed() {
+        uint64_t ticks = (uint64_t)std::chrono::high_resolution_clock::now().time_since_epoch().count();
+        return hash32((uint32_t)ticks ^ hash32((uint32_t)(ticks >> 32)) ^ hash32((uint32_t)time(nullptr)));
+    }
+}
@@ -0,0 +1,257 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <vector>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <cstdint>
+#include "Block.hpp"
+#include "Chunk.hpp"
+
+// 射线命中结果; 未命中时 type 为空气
+struct RayHit {
+    glm::ivec3 block = glm::ivec3(0);   // 命中的方块坐标
+    glm::ivec3 normal = glm::ivec3(0);  // 射线进入该方块时穿过的面的法线 (起点就在方块内时为 0)
+    float distance = 0.0f;              // 起点到命中面的距离 (以 direction 的长度为单位)
+    BlockType type = BLOCK_AIR;
+};
+
+// 批量查询中的一条射线
+struct Ray {
+    glm::vec3 origin;
+    glm::vec3 direction;
+    float maxDistance;
+};
+
+/*
+    体素网格射线遍历 (Amanatides & Woo) 的状态: 按射线穿过的顺序恰好访问每个格子一次, 不会漏掉擦过的棱角
+    cell 为当前格子, t 为射线进入该格子时的参数; 坐标用 floor 取整, 负坐标也能正确处理
+*/
+struct VoxelTraversal {
+    glm::ivec3 cell;
+    glm::ivec3 step = glm::ivec3(0);
+    glm::ivec3 normal = glm::ivec3(0);  // 进入当前格子时穿过的面的法线
+    glm::vec3 tMax;                     // 各轴到下一个格子边界的 t
+    glm::vec3 tDelta;                   // 各轴穿过一整格的 t
+    float t = 0.0f;
+
+    VoxelTraversal(const glm::vec3& origin, const glm::vec3& direction)
+        : cell(std::floor(origin.x), std::floor(origin.y), std::floor(origin.z)),
+          tMax(std::numeric_limits<float>::infinity()), tDelta(std::numeric_limits<float>::infinity()) {
+        for (int axis = 0; axis < 3; ++axis) {
+            if (direction[axis] > 0.0f) {
+                step[axis] = 1;
+                tDelta[axis] = 1.0f / direction[axis];
+                tMax[axis] = (cell[axis] + 1 - origin[axis]) * tDelta[axis];
+            } else if (direction[axis] < 0.0f) {
+                step[axis] = -1;
+                tDelta[axis] = -1.0f / direction[axis];
+                tMax[axis] = (origin[axis] - cell[axis]) * tDelta[axis];
+            }
+        }
+    }
+
+    // 前进到下一个格子 (方向为零向量时 t 变为无穷大)
+    void next() {
+        int axis = tMax.x < tMax.y ? (tMax.x < tMax.z ? 0 : 2) : (tMax.y < tMax.z ? 1 : 2);
+        t = tMax[axis];
+        cell[axis] += step[axis];
+        tMax[axis] += tDelta[axis];
+        normal = glm::ivec3(0);
+        normal[axis] = -step[axis];
+    }
+
+    // 直接跳到离开当前格子所在的对齐立方体 (边长 2^shift) 后的第一个格子, 中间的格子不再逐个访问
+    void leaveCube(int shift) {
+        const float infinity = std::numeric_limits<float>::infinity();
+        glm::ivec3 remaining(0);        // 离开立方体之前在各轴上还要穿过的格子边界数
+        glm::vec3 tLeave(infinity);     // 各轴上离开立方体的 t
+        for (int axis = 0; axis < 3; ++axis) {
+            if (step[axis] == 0) continue;
+            int cube = cell[axis] >> shift;
+            remaining[axis] = step[axis] > 0 ? ((cube + 1) << shift) - 1 - cell[axis] : cell[axis] - (cube << shift);
+            tLeave[axis] = tMax[axis] + remaining[axis] * tDelta[axis];
+        }
+        int axis = tLeave.x < tLeave.y ? (tLeave.x < tLeave.z ? 0 : 2) : (tLeave.y < tLeave.z ? 1 : 2);
+        if (tLeave[axis] == infinity) {
+            t = infinity;
+            return;
+        }
+        for (int other = 0; other < 3; ++other) {
+            if (other == axis || step[other] == 0) continue;
+            // 在离开立方体之前, 该轴上穿过的边界数
+            int crossed = std::max(0, std::min(remaining[other], (int)std::ceil((tLeave[axis] - tMax[other]) / tDelta[other])));
+            cell[other] += step[other] * crossed;
+            tMax[other] += crossed * tDelta[other];
+        }
+        t = tLeave[axis];
+        cell[axis] += step[axis] * (remaining[axis] + 1);
+        tMax[axis] = tLeave[axis] + tDelta[axis];
+        normal = glm::ivec3(0);
+        normal[axis] = -step[axis];
+    }
+};
+
+/*
+    单条射线查询: getBlock(x, y, z) 返回格子中的方块, 遇到第一个非空气方块时返回 true;
+    超过 maxDistance 仍未命中时返回 false
+*/
+template <typename GetBlock>
+bool raycastVoxels(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, GetBlock&& getBlock, RayHit& hit) {
+    VoxelTraversal ray(origin, direction);
+    while (ray.t <= maxDistance) {
+        BlockType type = getBlock(ray.cell.x, ray.cell.y, ray.cell.z);
+        if (type != BLOCK_AIR) {
+            hit.block = ray.cell;
+            hit.normal = ray.normal;
+            hit.distance = ray.t;
+            hit.type = type;
+            return true;
+        }
+        ray.next();
+    }
+    return false;
+}
+
+/*
+    粗粒度占用表: 世界按 8x8x8 方块划分为砖块, 记录每个砖块是否可能含有非空气方块, 批量射线查询据此跳过空的砖块
+    尚未计算过的砖块视为占用; 方块改为空气时不清除标记 (仍是正确的, 只是跳过得少一些), 区块重新构建网格时再精确计算
+    build 在工作线程、markSolid 在主线程调用
+*/
+class VoxelOccupancy {
+public:
+    static const int BRICK_SHIFT = 3;
+    static const int BRICK_SIZE = 1 << BRICK_SHIFT;
+
+    int bricksX, bricksY, bricksZ;
+
+    VoxelOccupancy(int w, int h, int d)
+        : bricksX((w + BRICK_SIZE - 1) >> BRICK_SHIFT), bricksY((h + BRICK_SIZE - 1) >> BRICK_SHIFT), bricksZ((d + BRICK_SIZE - 1) >> BRICK_SHIFT),
+          occupied(bricksX * bricksY * bricksZ) {
+        for (std::atomic<uint8_t>& brick : occupied) {
+            brick.store(1, std::memory_order_relaxed);
+        }
+    }
+
+    // 按区块当前的方块数据重新计算其覆盖的砖块 (调用时区块的方块数据须已解压, 且不会被其他线程修改)
+    void build(const Chunk& chunk, int worldHeight) {
+        const int bricksPerChunk = CHUNK_SIZE / BRICK_SIZE;
+        for (int bx = 0; bx < bricksPerChunk; ++bx) {
+            for (int bz = 0; bz < bricksPerChunk; ++bz) {
+                int brickX = chunk.cx * bricksPerChunk + bx, brickZ = chunk.cz * bricksPerChunk + bz;
+                if (brickX >= bricksX || brickZ >= bricksZ) continue;
+                for (int by = 0; by < bricksY; ++by) {
+                    bool solid = false;
+                    for (int y = by * BRICK_SIZE; y < std::min(worldHeight, (by + 1) * BRICK_SIZE) && !solid; ++y) {
+                        for (int lz = bz * BRICK_SIZE; lz < (bz + 1) * BRICK_SIZE && !solid; ++lz) {
+                            const uint8_t* row = chunk.blocks.data() + ChunkGrid::blockIndex(bx * BRICK_SIZE, y, lz);
+                            solid = std::any_of(row, row + BRICK_SIZE, [](uint8_t block) { return block != BLOCK_AIR; });
+                        }
+                    }
+                    occupied[index(brickX, by, brickZ)].store(solid ? 1 : 0, std::memory_order_relaxed);
+                }
+            }
+        }
+    }
+
+    // 方块被改为非空气时调用
+    void markSolid(int x, int y, int z) {
+        occupied[index(x >> BRICK_SHIFT, y >> BRICK_SHIFT, z >> BRICK_SHIFT)].store(1, std::memory_order_relaxed);
+    }
+
+    // 砖块坐标须在范围内
+    bool isEmpty(int bx, int by, int bz) const {
+        return occupied[index(bx, by, bz)].load(std::memory_order_relaxed) == 0;
+    }
+
+    // 已知为空的砖块所占比例
+    float emptyFraction() const {
+        size_t empty = 0;
+        for (const std::atomic<uint8_t>& brick : occupied) {
+            empty += brick.load(std::memory_order_relaxed) == 0;
+        }
+        return occupied.empty() ? 0.0f : (float)empty / occupied.size();
+    }
+
+private:
+    std::vector<std::atomic<uint8_t>> occupied;
+
+    int index(int bx, int by, int bz) const {
+        return (bx * bricksZ + bz) * bricksY + by;
+    }
+};
+
+/*
+    用占用表加速的单条射线查询, 结果与 raycastVoxels 相同 (世界外视为空气; 起点在世界外时, 恰好擦过棱角的射线可能因舍入而不同)
+    两级遍历: 当前格子所在的砖块为空时直接跳到离开砖块后的格子; 砖块不空时逐格检查,
+    砖块不跨区块, 进入砖块时取一次区块的方块数组, 之后直接按下标读取; 射线离开世界后即结束
+    会解压射线经过的冷区块, 因此与 ChunkCompressor 一样只在主线程调用
+*/
+inline bool raycastOccupancy(const ChunkGrid& grid, const VoxelOccupancy& occupancy, const Ray& query, RayHit& hit) {
+    const glm::ivec3 worldSize(grid.worldWidth, grid.worldHeight, grid.worldDepth);
+
+    // 起点在世界外时, 先求射线进入世界包围盒的位置 (slab 法), 从那里开始遍历
+    float tEnter = 0.0f, tExit = query.maxDistance;
+    int enterAxis = -1;
+    bool inside = query.origin.x >= 0.0f && query.origin.y >= 0.0f && query.origin.z >= 0.0f &&
+                  query.origin.x < worldSize.x && query.origin.y < worldSize.y && query.origin.z < worldSize.z;
+    for (int axis = 0; axis < 3 && !inside; ++axis) {
+        if (query.direction[axis] == 0.0f) {
+            if (query.origin[axis] < 0.0f || query.origin[axis] >= worldSize[axis]) return false;
+            continue;
+        }
+        float t0 = (0.0f - query.origin[axis]) / query.direction[axis];
+        float t1 = (worldSize[axis] - query.origin[axis]) / query.direction[axis];
+        if (t0 > t1) std::swap(t0, t1);
+        if (t0 > tEnter) {
+            tEnter = t0;
+            enterAxis = axis;
+        }
+        tExit = std::min(tExit, t1);
+    }
+    if (tEnter > tExit) return false;
+    glm::vec3 start = query.origin + query.direction * tEnter;
+    for (int axis = 0; axis < 3; ++axis) {
+        start[axis] = std::max(0.0f, std::min(start[axis], std::nextafter((float)worldSize[axis], 0.0f))); // 舍入误差可能使进入点略微落在世界外
+    }
+    VoxelTraversal ray(start, query.direction);
+    if (enterAxis >= 0) ray.normal[enterAxis] = query.direction[enterAxis] > 0.0f ? -1 : 1;
+    float maxDistance = query.maxDistance - tEnter;
+
+    while (ray.t <= maxDistance) {
+        if (!grid.isInsideWorld(ray.cell.x, ray.cell.y, ray.cell.z)) return false; // 世界是凸的, 离开后不会再进入
+
+        glm::ivec3 brick = ray.cell >> VoxelOccupancy::BRICK_SHIFT;
+        if (occupancy.isEmpty(brick.x, brick.y, brick.z)) {
+            ray.leaveCube(VoxelOccupancy::BRICK_SHIFT);
+            continue;
+        }
+
+        const Chunk& chunk = grid.chunks[(ray.cell.x / CHUNK_SIZE) * grid.chunksZ + ray.cell.z / CHUNK_SIZE];
+        if (chunk.blocks.empty()) grid.unpack(chunk); // 被压缩的冷区块
+        const uint8_t* blocks = chunk.blocks.data();
+        do {
+            uint8_t block = blocks[ChunkGrid::blockIndex(ray.cell.x % CHUNK_SIZE, ray.cell.y, ray.cell.z % CHUNK_SIZE)];
+            if (block != BLOCK_AIR) {
+                hit.block = ray.cell;
+                hit.normal = ray.normal;
+                hit.distance = tEnter + ray.t;
+                hit.type = static_cast<BlockType>(block);
+                return true;
+            }
+            ray.next();
+        } while (ray.t <= maxDistance && ray.cell.y < worldSize.y && (ray.cell >> VoxelOccupancy::BRICK_SHIFT) == brick);
+    }
+    return false;
+}
+
+// 批量射线查询: hits[i] 为 rays[i] 的结果 (未命中时 type 为空气), 返回命中的射线数
+inline size_t raycastBatch(const ChunkGrid& grid, const VoxelOccupancy& occupancy, const Ray* rays, size_t count, RayHit* hits) {
+    size_t hitCount = 0;
+    for (size_t i = 0; i < count; ++i) {
+        hits[i] = RayHit();
+        hitCount += raycastOccupancy(grid, occupancy, rays[i], hits[i]);
+    }
+    return hitCount;
+}
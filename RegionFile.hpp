@@ -0,0 +1,439 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <filesystem>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include "Chunk.hpp"
+#include "ChunkCodec.hpp"
+#include "MappedFile.hpp"
+#include "ChunkIO.hpp"
+
+/*
+    区域文件: 一个文件保存 32x32 个区块
+    文件按 4KB 扇区划分: 第 0 扇区为文件头, 第 1-4 扇区为偏移表 (每个区块一项: 起始扇区、扇区数、字节数),
+    之后是各区块压缩后的数据, 每个区块占用连续的整数个扇区
+    读取通过内存映射进行, 区块数据直接从映射的页面解码到区块存储, 不经过中间缓冲区;
+    文件只会变长, 读取的数据超出当前映射范围时才重新映射
+    写入总是先分配与旧数据不重叠的扇区, 写完数据后才更新偏移表, 中途退出时旧数据仍然有效
+    durable 时数据和偏移表各自落盘 (fsync) 后才进入下一步, 旧扇区在新偏移表落盘后才释放, 掉电时同样成立
+*/
+class RegionFile {
+public:
+    static const int REGION_SIZE = 32;    // 区域边长 (区块)
+    static const int CHUNK_COUNT = REGION_SIZE * REGION_SIZE;
+    static const int SECTOR_SIZE = 4096;  // 扇区大小 (字节)
+    static const uint32_t fileMagic = 0x4E474552; // "REGN"
+    static const uint32_t formatVersion = 1;
+
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t formatVersion;
+        uint32_t generatorVersion;
+        int32_t seed;
+        int32_t worldHeight;
+        int32_t regionX, regionZ;
+    };
+
+    struct Entry {
+        uint32_t sectorOffset; // 起始扇区, 0 表示区块不存在
+        uint32_t sectorCount;  // 占用的扇区数
+        uint32_t length;       // 数据字节数
+        uint32_t reserved;
+    };
+
+    static const int TABLE_SECTORS = CHUNK_COUNT * sizeof(Entry) / SECTOR_SIZE;
+    static const int DATA_SECTOR = 1 + TABLE_SECTORS; // 第一个数据扇区
+
+    // 打开区域文件; 文件不存在或文件头与 expected 不一致 (种子、生成器版本等) 时重新创建
+    // durable 为 false 时不落盘 (可以重新生成的缓存), 进程异常退出时旧数据仍然有效, 掉电时不保证
+    RegionFile(const std::string& path, const FileHeader& expected, bool durable = true)
+        : path(path), durable(durable), entries(CHUNK_COUNT) {
+        if (!readTable(expected)) {
+            createEmpty(expected);
+        }
+        opened = file.open(path, false);
+    }
+
+    // 读取区块 (lx, lz) 的数据, 交给 consume 解码; consume 收到的指针指向映射的文件内容
+    bool read(int lx, int lz, const std::function<bool(const uint8_t*, size_t)>& consume) {
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            const Entry& entry = entries[lx * REGION_SIZE + lz];
+            if (entry.sectorOffset == 0) return false;
+            size_t begin = (size_t)entry.sectorOffset * SECTOR_SIZE;
+            if (mapping.isOpen() && begin + entry.length <= mapping.size()) {
+                return consume(mapping.data() + begin, entry.length);
+            }
+        }
+
+        // 数据在上次映射之后追加到文件末尾, 重新映射整个文件 (文件长度总是扇区的整数倍)
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        const Entry& entry = entries[lx * REGION_SIZE + lz];
+        if (entry.sectorOffset == 0) return false;
+        size_t begin = (size_t)entry.sectorOffset * SECTOR_SIZE;
+        if (!mapping.isOpen() || begin + entry.length > mapping.size()) mapping.open(path);
+        if (!mapping.isOpen() || begin + entry.length > mapping.size()) return false;
+        return consume(mapping.data() + begin, entry.length);
+    }
+
+    // 写入区块 (lx, lz) 的数据
+    bool write(int lx, int lz, const std::vector<uint8_t>& payload) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        if (!opened) return false;
+
+        uint32_t needed = (uint32_t)((payload.size() + SECTOR_SIZE - 1) / SECTOR_SIZE);
+        uint32_t offset = allocate(needed);
+        markSectors(offset, needed, true);
+
+        // 数据补齐到整扇区, 文件长度始终是扇区的整数倍
+        std::vector<uint8_t> sectors(needed * SECTOR_SIZE, 0);
+        std::memcpy(sectors.data(), payload.data(), payload.size());
+        if (file.write((uint64_t)offset * SECTOR_SIZE, sectors.data(), (uint32_t)sectors.size()) != (int64_t)sectors.size()
+            || (durable && !file.sync())) {
+            markSectors(offset, needed, false);
+            return false;
+        }
+        return updateEntry(lx, lz, { offset, needed, (uint32_t)payload.size(), 0 }) && syncTable();
+    }
+
+    // 查询区块 (lx, lz) 在文件中的位置, 供批量 I/O 直接读取; 区块不存在时返回 false
+    bool locate(int lx, int lz, Entry& entry) {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        entry = entries[lx * REGION_SIZE + lz];
+        return entry.sectorOffset != 0;
+    }
+
+    // 批量写入的第一步: 分配 count 个与现有数据不重叠的扇区, 调用方随后自行写入数据
+    uint32_t reserve(uint32_t count) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        uint32_t offset = allocate(count);
+        markSectors(offset, count, true);
+        return offset;
+    }
+
+    // 批量写入失败时归还 reserve 分配的扇区
+    void release(uint32_t offset, uint32_t count) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        markSectors(offset, count, false);
+    }
+
+    // 批量写入的第二步: 数据写完并 sync 之后更新偏移表; 旧数据占用的扇区在下一次 sync 时释放
+    bool commit(int lx, int lz, uint32_t offset, uint32_t count, uint32_t length) {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        if (!opened) return false;
+        return updateEntry(lx, lz, { offset, count, length, 0 });
+    }
+
+    // 把已写入的数据和偏移表落盘, 然后释放被替换的旧扇区; 批量写入在提交偏移表前后各调用一次
+    bool sync() {
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        return syncTable();
+    }
+
+    const std::string& getPath() const {
+        return path;
+    }
+
+    // 文件占用的扇区数 (含文件头和偏移表)
+    int sectorCount() {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        return (int)usedSectors.size();
+    }
+
+private:
+    std::string path;
+    bool durable;
+    IOFile file;
+    bool opened = false;
+    std::shared_mutex mutex;
+    std::vector<Entry> entries;
+    std::vector<char> usedSectors; // 每个扇区是否被占用
+    std::vector<std::pair<uint32_t, uint32_t>> pendingFree; // 已被替换、等偏移表落盘后释放的扇区 (起始扇区, 扇区数)
+    MappedFile mapping;
+
+    // 更新文件和内存中的偏移表项 (调用方持有写锁), 旧扇区留到 syncTable 时释放
+    // 先写文件: 写入失败时内存中的表项保持不变, 仍与磁盘上的偏移表一致, 新分配的扇区归还
+    bool updateEntry(int lx, int lz, const Entry& updated) {
+        uint64_t position = (uint64_t)SECTOR_SIZE + (lx * REGION_SIZE + lz) * sizeof(Entry);
+        if (file.write(position, &updated, sizeof(updated)) != (int64_t)sizeof(updated)) {
+            markSectors(updated.sectorOffset, updated.sectorCount, false);
+            return false;
+        }
+        Entry& entry = entries[lx * REGION_SIZE + lz];
+        if (entry.sectorOffset != 0) pendingFree.push_back({ entry.sectorOffset, entry.sectorCount });
+        markSectors(updated.sectorOffset, updated.sectorCount, true);
+        entry = updated;
+        return true;
+    }
+
+    // 偏移表落盘后, 旧偏移表不可能再被读到, 它指向的扇区可以重新分配 (调用方持有写锁)
+    bool syncTable() {
+        if (durable && !file.sync()) return false;
+        for (const std::pair<uint32_t, uint32_t>& range : pendingFree) {
+            markSectors(range.first, range.second, false);
+        }
+        pendingFree.clear();
+        return true;
+    }
+
+    bool readTable(const FileHeader& expected) {
+        std::ifstream input(path, std::ios::binary | std::ios::ate);
+        if (!input) return false;
+        std::streamoff fileSize = input.tellg();
+        if (fileSize < (std::streamoff)DATA_SECTOR * SECTOR_SIZE) return false;
+
+        FileHeader header;
+        input.seekg(0);
+        input.read(reinterpret_cast<char*>(&header), sizeof(header));
+        if (!input || header.magic != expected.magic || header.formatVersion != expected.formatVersion
+            || header.generatorVersion != expected.generatorVersion || header.seed != expected.seed
+            || header.worldHeight != expected.worldHeight || header.regionX != expected.regionX || header.regionZ != expected.regionZ) {
+            return false;
+        }
+
+        input.seekg(SECTOR_SIZE);
+        input.read(reinterpret_cast<char*>(entries.data()), entries.size() * sizeof(Entry));
+        if (!input) return false;
+
+        usedSectors.assign((size_t)(fileSize / SECTOR_SIZE), 0);
+        std::fill(usedSectors.begin(), usedSectors.begin() + DATA_SECTOR, 1);
+        for (Entry& entry : entries) {
+            // 越界或与文件头重叠的项视为损坏, 丢弃
+            if (entry.sectorOffset != 0 && (entry.sectorOffset < DATA_SECTOR || entry.sectorOffset + entry.sectorCount > usedSectors.size()
+                || entry.length > entry.sectorCount * (uint32_t)SECTOR_SIZE)) {
+                entry = Entry{};
+            }
+            markSectors(entry.sectorOffset, entry.sectorCount, true);
+        }
+        return true;
+    }
+
+    void createEmpty(const FileHeader& header) {
+        std::fill(entries.begin(), entries.end(), Entry{});
+        std::vector<char> sectors(DATA_SECTOR * SECTOR_SIZE, 0);
+        std::memcpy(sectors.data(), &header, sizeof(header));
+        std::ofstream output(path, std::ios::binary | std::ios::trunc);
+        output.write(sectors.data(), sectors.size());
+        usedSectors.assign(DATA_SECTOR, 1);
+    }
+
+    void markSectors(uint32_t offset, uint32_t count, bool used) {
+        if (offset == 0) return; // 区块不存在
+        if (usedSectors.size() < offset + count) usedSectors.resize(offset + count, 0);
+        std::fill(usedSectors.begin() + offset, usedSectors.begin() + offset + count, used ? 1 : 0);
+    }
+
+    // 首次适配: 找到第一段足够长的空闲扇区, 没有时追加到文件末尾
+    uint32_t allocate(uint32_t count) {
+        uint32_t runStart = DATA_SECTOR, runLength = 0;
+        for (uint32_t sector = DATA_SECTOR; sector < usedSectors.size(); ++sector) {
+            if (usedSectors[sector]) {
+                runStart = sector + 1;
+                runLength = 0;
+            } else if (++runLength == count) {
+                return runStart;
+            }
+        }
+        return runStart; // 末尾的空闲段加上文件之外的部分
+    }
+};
+
+// 按区域文件保存区块的存储, 区域文件按需打开, 可以在多个线程中同时读写
+class RegionStorage {
+public:
+    // durable 见 RegionFile
+    RegionStorage(const std::string& directory, const RegionFile::FileHeader& header, bool durable = true)
+        : directory(directory), header(header), durable(durable) {
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+    }
+
+    bool load(Chunk& chunk) {
+        return region(chunk.cx, chunk.cz).read(localCoord(chunk.cx), localCoord(chunk.cz), [&chunk](const uint8_t* data, size_t size) {
+            return ChunkCodec::decodeChunk(data, size, chunk);
+        });
+    }
+
+    bool save(const Chunk& chunk) {
+        return region(chunk.cx, chunk.cz).write(localCoord(chunk.cx), localCoord(chunk.cz), ChunkCodec::encodeChunk(chunk));
+    }
+
+    // 通过 I/O 后端批量载入区块: 按扇区读取原始数据 (可绕过页缓存), 全部完成后解码
+    // 返回成功载入的区块数, loaded[i] 表示 chunks[i] 是否载入; latencies 非空时收集每个请求的延迟
+    int loadBatch(const std::vector<Chunk*>& chunks, ChunkIOBackend& backend, bool direct, std::vector<char>& loaded,
+                  std::vector<float>* latencies = nullptr) {
+        std::map<RegionFile*, std::unique_ptr<IOFile>> files;
+        std::vector<IORequest> requests;
+        std::vector<size_t> owners;   // 请求对应的区块下标
+        std::vector<uint32_t> lengths; // 数据实际字节数
+        size_t totalBytes = 0;
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            RegionFile& file = region(chunks[i]->cx, chunks[i]->cz);
+            RegionFile::Entry entry;
+            if (!file.locate(localCoord(chunks[i]->cx), localCoord(chunks[i]->cz), entry)) continue;
+            IORequest request;
+            request.file = openFile(files, file, direct);
+            request.offset = (uint64_t)entry.sectorOffset * RegionFile::SECTOR_SIZE;
+            request.length = entry.sectorCount * RegionFile::SECTOR_SIZE;
+            if (!request.file) continue;
+            requests.push_back(request);
+            owners.push_back(i);
+            lengths.push_back(entry.length);
+            totalBytes += request.length;
+        }
+
+        // 所有请求共用一块对齐的缓冲区
+        AlignedBuffer buffer;
+        buffer.resize(totalBytes);
+        size_t offset = 0;
+        for (IORequest& request : requests) {
+            request.buffer = buffer.data() + offset;
+            offset += request.length;
+        }
+        backend.execute(requests);
+
+        loaded.assign(chunks.size(), 0);
+        int count = 0;
+        for (size_t i = 0; i < requests.size(); ++i) {
+            if (requests[i].result < (int64_t)lengths[i]) continue;
+            if (ChunkCodec::decodeChunk(requests[i].buffer, lengths[i], *chunks[owners[i]])) {
+                loaded[owners[i]] = 1;
+                count++;
+            }
+        }
+        collectLatencies(requests, latencies);
+        return count;
+    }
+
+    // 通过 I/O 后端批量保存区块: 先为每个区块分配新扇区, 整批写完并落盘后再更新偏移表
+    int saveBatch(const std::vector<const Chunk*>& chunks, ChunkIOBackend& backend, bool direct, std::vector<float>* latencies = nullptr) {
+        std::map<RegionFile*, std::unique_ptr<IOFile>> files;
+        std::vector<std::vector<uint8_t>> payloads(chunks.size());
+        size_t totalBytes = 0;
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            payloads[i] = ChunkCodec::encodeChunk(*chunks[i]);
+            totalBytes += sectorsFor(payloads[i].size()) * RegionFile::SECTOR_SIZE;
+        }
+
+        AlignedBuffer buffer;
+        buffer.resize(totalBytes); // 新分配的缓冲区已清零, 扇区末尾的补齐部分为 0
+        std::vector<IORequest> requests;
+        std::vector<RegionFile*> targets;
+        size_t offset = 0;
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            RegionFile& file = region(chunks[i]->cx, chunks[i]->cz);
+            uint32_t sectors = sectorsFor(payloads[i].size());
+            IORequest request;
+            request.file = openFile(files, file, direct);
+            request.offset = (uint64_t)file.reserve(sectors) * RegionFile::SECTOR_SIZE;
+            request.length = sectors * RegionFile::SECTOR_SIZE;
+            request.buffer = buffer.data() + offset;
+            request.write = true;
+            std::memcpy(request.buffer, payloads[i].data(), payloads[i].size());
+            offset += request.length;
+            requests.push_back(request);
+            targets.push_back(&file);
+        }
+        backend.execute(requests);
+
+        // 数据先落盘, 偏移表才能指向它; 偏移表落盘后再释放旧扇区
+        std::vector<RegionFile*> touched = targets;
+        std::sort(touched.begin(), touched.end());
+        touched.erase(std::unique(touched.begin(), touched.end()), touched.end());
+        std::vector<char> synced(touched.size(), 0);
+        for (size_t i = 0; i < touched.size(); ++i) {
+            synced[i] = touched[i]->sync();
+        }
+
+        int count = 0;
+        for (size_t i = 0; i < requests.size(); ++i) {
+            uint32_t offset = (uint32_t)(requests[i].offset / RegionFile::SECTOR_SIZE);
+            uint32_t sectors = requests[i].length / RegionFile::SECTOR_SIZE;
+            bool written = requests[i].file && requests[i].result == (int64_t)requests[i].length
+                && synced[std::lower_bound(touched.begin(), touched.end(), targets[i]) - touched.begin()];
+            if (!written) {
+                targets[i]->release(offset, sectors); // 写入失败, 归还预留的扇区
+                continue;
+            }
+            if (targets[i]->commit(localCoord(chunks[i]->cx), localCoord(chunks[i]->cz), offset, sectors, (uint32_t)payloads[i].size())) {
+                count++;
+            }
+        }
+        for (RegionFile* file : touched) {
+            file->sync();
+        }
+        collectLatencies(requests, latencies);
+        return count;
+    }
+
+    const std::string& getDirectory() const {
+        return directory;
+    }
+
+    // 已打开的区域文件占用的总字节数
+    long long diskBytes() {
+        std::lock_guard<std::mutex> lock(regionsMutex);
+        long long bytes = 0;
+        for (auto& region : regions) {
+            bytes += (long long)region.second->sectorCount() * RegionFile::SECTOR_SIZE;
+        }
+        return bytes;
+    }
+
+private:
+    std::string directory;
+    RegionFile::FileHeader header;
+    bool durable;
+    std::mutex regionsMutex;
+    std::map<std::pair<int, int>, std::unique_ptr<RegionFile>> regions;
+
+    static void collectLatencies(const std::vector<IORequest>& requests, std::vector<float>* latencies) {
+        if (!latencies) return;
+        for (const IORequest& request : requests) {
+            latencies->push_back(request.latencyMs);
+        }
+    }
+
+    static uint32_t sectorsFor(size_t bytes) {
+        return (uint32_t)((bytes + RegionFile::SECTOR_SIZE - 1) / RegionFile::SECTOR_SIZE);
+    }
+
+    static IOFile* openFile(std::map<RegionFile*, std::unique_ptr<IOFile>>& files, RegionFile& region, bool direct) {
+        std::unique_ptr<IOFile>& file = files[&region];
+        if (!file) {
+            file = std::make_unique<IOFile>();
+            if (!file->open(region.getPath(), direct)) file->close();
+        }
+        return file.get();
+    }
+
+    static int regionCoord(int chunkCoord) {
+        return chunkCoord >= 0 ? chunkCoord / RegionFile::REGION_SIZE : (chunkCoord + 1) / RegionFile::REGION_SIZE - 1;
+    }
+
+    static int localCoord(int chunkCoord) {
+        return chunkCoord - regionCoord(chunkCoord) * RegionFile::REGION_SIZE;
+    }
+
+    RegionFile& region(int cx, int cz) {
+        int rx = regionCoord(cx), rz = regionCoord(cz);
+        std::lock_guard<std::mutex> lock(regionsMutex);
+        std::unique_ptr<RegionFile>& file = regions[{ rx, rz }];
+        if (!file) {
+            RegionFile::FileHeader regionHeader = header;
+            regionHeader.regionX = rx;
+            regionHeader.regionZ = rz;
+            std::string path = directory + "/r." + std::to_string(rx) + "." + std::to_string(rz) + ".region";
+            file = std::make_unique<RegionFile>(path, regionHeader, durable);
+        }
+        return *file;
+    }
+};
@@ -0,0 +1,33 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+// 游程编码: (长度 1..255, 值) 字节对
+// 方块数组以水平切片为单位排列, 地下整层的石头和地上整层的空气都是长段, 压缩率很高
+namespace RunLength {
+    inline void encode(const uint8_t* data, size_t size, std::vector<uint8_t>& out) {
+        size_t i = 0;
+        while (i < size) {
+            uint8_t value = data[i];
+            size_t run = 1;
+            while (i + run < size && run < 255 && data[i + run] == value) run++;
+            out.push_back((uint8_t)run);
+            out.push_back(value);
+            i += run;
+        }
+    }
+
+    // 解码到 out, 长度必须恰好为 outSize; 数据损坏时返回 false
+    inline bool decode(const uint8_t* data, size_t size, uint8_t* out, size_t outSize) {
+        size_t written = 0;
+        for (size_t i = 0; i + 1 < size; i += 2) {
+            size_t run = data[i];
+            if (run == 0 || written + run > outSize) return false;
+            std::memset(out + written, data[i + 1], run);
+            written += run;
+        }
+        return written == outSize && size % 2 == 0;
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <vector>
+#include <map>
+#include <tuple>
+#include <cstdint>
+#include <algorithm>
+#include "Block.hpp"
+#include "Chunk.hpp"
+
+// 结构中某一列上连续的同种方块
+struct StructureRun {
+    int dx, dz;      // 相对结构原点的列偏移
+    int y0, length;  // 相对原点的起始高度和长度
+    uint8_t block;
+};
+
+/*
+    结构模板 (树木等地物)
+    先用 set 逐个体素描述模板, 再 compile 成按列排序的连续段列表, 之后可以反复粘贴:
+    粘贴时逐段整列写入区块存储, 不逐格调用 setBlock, 也没有逐格的分支
+    粘贴只写入目标区块, 落在区块之外的部分被裁掉, 由相邻区块在自己的装饰阶段粘贴同一个结构补齐
+*/
+class StructureStamp {
+public:
+    int minDx = 0, maxDx = -1, minDz = 0, maxDz = -1; // 水平包围盒 (相对原点, 含两端)
+
+    void set(int dx, int dy, int dz, BlockType block) {
+        voxels[std::make_tuple(dx, dz, dy)] = block;
+    }
+
+    // 把体素合并为按 (dx, dz, y) 排序的连续段
+    void compile() {
+        runs.clear();
+        for (const auto& voxel : voxels) {
+            int dx = std::get<0>(voxel.first), dz = std::get<1>(voxel.first), dy = std::get<2>(voxel.first);
+            if (!runs.empty()) {
+                StructureRun& last = runs.back();
+                if (last.dx == dx && last.dz == dz && last.y0 + last.length == dy && last.block == voxel.second) {
+                    last.length++;
+                    continue;
+                }
+            }
+            runs.push_back({ dx, dz, dy, 1, voxel.second });
+        }
+        voxels.clear();
+
+        if (!runs.empty()) {
+            minDx = maxDx = runs.front().dx;
+            minDz = maxDz = runs.front().dz;
+        }
+        for (const StructureRun& run : runs) {
+            minDx = std::min(minDx, run.dx);
+            maxDx = std::max(maxDx, run.dx);
+            minDz = std::min(minDz, run.dz);
+            maxDz = std::max(maxDz, run.dz);
+        }
+    }
+
+    // 原点位于世界坐标 (x, z) 时是否与区块 (cx, cz) 相交
+    bool overlapsChunk(int cx, int cz, int x, int z) const {
+        int x0 = cx * CHUNK_SIZE, z0 = cz * CHUNK_SIZE;
+        return x + maxDx >= x0 && x + minDx < x0 + CHUNK_SIZE && z + maxDz >= z0 && z + minDz < z0 + CHUNK_SIZE;
+    }
+
+    // 把原点位于世界坐标 (x, y, z) 的结构粘贴到区块, 裁掉区块和世界之外的部分; 返回写入的方块数
+    int paste(const ChunkGrid& grid, Chunk& chunk, int x, int y, int z) const {
+        if (!overlapsChunk(chunk.cx, chunk.cz, x, z)) return 0;
+
+        int x0 = chunk.cx * CHUNK_SIZE, z0 = chunk.cz * CHUNK_SIZE;
+        int columnsX = std::min(CHUNK_SIZE, grid.worldWidth - x0), columnsZ = std::min(CHUNK_SIZE, grid.worldDepth - z0);
+        int written = 0;
+        for (const StructureRun& run : runs) {
+            int lx = x + run.dx - x0, lz = z + run.dz - z0;
+            if (lx < 0 || lx >= columnsX || lz < 0 || lz >= columnsZ) continue;
+            int yBegin = std::max(0, y + run.y0), yEnd = std::min(grid.worldHeight, y + run.y0 + run.length);
+            for (int yy = yBegin; yy < yEnd; ++yy) {
+                chunk.blocks[ChunkGrid::blockIndex(lx, yy, lz)] = run.block;
+            }
+            written += std::max(0, yEnd - yBegin);
+        }
+        return written;
+    }
+
+    int runCount() const {
+        return (int)runs.size();
+    }
+
+private:
+    std::map<std::tuple<int, int, int>, uint8_t> voxels; // 编辑中的体素, 键为 (dx, dz, dy)
+    std::vector<StructureRun> runs;
+};
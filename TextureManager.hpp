@@ -21,6 +21,8 @@ enum TextureType {
     TEXTURE_GLASS,
     TEXTURE_OAK_PLANKS,
     TEXTURE_STONE_BRICKS,
+    TEXTURE_WATER,
+    TEXTURE_GLOWSTONE,
     TEXTURE_COUNT
 };
 
@@ -40,6 +42,8 @@ public:
         "assets/glass.png",
         "assets/oak_planks.png",
         "assets/stone_bricks.png",
+        "assets/water.png",
+        "assets/glowstone.png",
     };
 
     TextureManager() : textureArrayID(0) {}
@@ -135,6 +139,9 @@ public:
 };
 
 int getTextureLayer(BlockType type) {
+    if (isWater(type)) {
+        return 13; // water.png (水源和流动的水)
+    }
     switch(type) {
         case BlockType::BLOCK_AIR:
             return 0;  // Empty texture layer
@@ -156,6 +163,8 @@ int getTextureLayer(BlockType type) {
             return 11; // oak_planks.png
         case BlockType::STONE_BRICKS:
             return 12; // stone_bricks.png
+        case BlockType::GLOWSTONE:
+            return 14; // glowstone.png
         default:
             return 0;
     }
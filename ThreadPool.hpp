@@ -0,0 +1,127 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <iterator>
+
+// 带优先级的工作线程池
+// 任务的 priority 越小越先执行; 主线程可随时重新计算优先级并取消过期任务
+class ThreadPool {
+public:
+    struct Job {
+        float priority;                  // 优先级 (越小越优先)
+        int tag;                         // 调用方自定义标识 (如区块索引)
+        std::function<void()> task;      // 任务本体 (在工作线程中执行)
+        std::function<void()> onCancel;  // 任务被取消时的回调 (在调用取消的线程中执行)
+    };
+
+private:
+    std::vector<std::thread> workers;
+    std::vector<Job> jobs;               // 以 priority 为键的小根堆
+    std::mutex jobsMutex;
+    std::condition_variable jobsCondition;
+    bool stopping = false;
+    int runningJobs = 0;
+
+    static bool heapCompare(const Job& a, const Job& b) {
+        return a.priority > b.priority;
+    }
+
+    void workerLoop() {
+        while (true) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(jobsMutex);
+                jobsCondition.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (stopping) return;
+                std::pop_heap(jobs.begin(), jobs.end(), heapCompare);
+                job = std::move(jobs.back());
+                jobs.pop_back();
+                runningJobs++;
+            }
+            job.task();
+            {
+                std::lock_guard<std::mutex> lock(jobsMutex);
+                runningJobs--;
+            }
+        }
+    }
+
+public:
+    // threadCount <= 0 时使用 (硬件线程数 - 1), 至少 1 个
+    explicit ThreadPool(int threadCount = 0) {
+        if (threadCount <= 0) {
+            threadCount = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+        }
+        for (int i = 0; i < threadCount; ++i) {
+            workers.emplace_back(&ThreadPool::workerLoop, this);
+        }
+    }
+
+    ~ThreadPool() {
+        stop();
+    }
+
+    // 停止所有线程, 未执行的任务直接丢弃 (不调用 onCancel)
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(jobsMutex);
+            if (stopping) return;
+            stopping = true;
+            jobs.clear();
+        }
+        jobsCondition.notify_all();
+        for (auto& worker : workers) {
+            if (worker.joinable()) worker.join();
+        }
+    }
+
+    void submit(Job job) {
+        {
+            std::lock_guard<std::mutex> lock(jobsMutex);
+            jobs.push_back(std::move(job));
+            std::push_heap(jobs.begin(), jobs.end(), heapCompare);
+        }
+        jobsCondition.notify_one();
+    }
+
+    // 重新计算所有等待中任务的优先级
+    // score 返回 false 表示任务已过期, 将被移除并调用其 onCancel
+    void reprioritize(const std::function<bool(Job&)>& score) {
+        std::vector<Job> cancelled;
+        {
+            std::lock_guard<std::mutex> lock(jobsMutex);
+            auto keepEnd = std::partition(jobs.begin(), jobs.end(), [&](Job& job) { return score(job); });
+            std::move(keepEnd, jobs.end(), std::back_inserter(cancelled));
+            jobs.erase(keepEnd, jobs.end());
+            std::make_heap(jobs.begin(), jobs.end(), heapCompare);
+        }
+        for (auto& job : cancelled) {
+            if (job.onCancel) job.onCancel();
+        }
+    }
+
+    // 等待中的任务数量
+    int pendingCount() {
+        std::lock_guard<std::mutex> lock(jobsMutex);
+        return (int)jobs.size();
+    }
+
+    // 等待所有已提交的任务执行完毕
+    void waitIdle() {
+        while (true) {
+            {
+                std::lock_guard<std::mutex> lock(jobsMutex);
+                if (jobs.empty() && runningJobs == 0) return;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    int threadCount() const {
+        return (int)workers.size();
+    }
+};
@@ -5,40 +5,111 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
-#include <FastNoiseLite.h>
 #include <vector>
+#include <atomic>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <thread>
+#include <chrono>
+#include "imgui.h"
 #include "Block.hpp"
+#include "Chunk.hpp"
+#include "ChunkPipeline.hpp"
+#include "ChunkCompressor.hpp"
+#include "Raycast.hpp"
+#include "Collision.hpp"
+#include "EntitySystem.hpp"
+#include "BlockTickScheduler.hpp"
+#include "FluidSimulation.hpp"
+#include "LightEngine.hpp"
+#include "PathService.hpp"
+#include "WorldGenerator.hpp"
+#include "ChunkCache.hpp"
+#include "MeshCache.hpp"
+#include "WorldSave.hpp"
+#include "Random.hpp"
 #include "ParticleSystem.hpp"
 #include "DayTime.hpp"
 #include "Wireframe.hpp"
 
-// 32位随机数生成器
-int rand32() {
-    return rand() << 16 | rand();
-}
 
 class World {
 public:
-    const int vertexCountPerBlock = 36;
-    const int attributesPerVertex = 6;
-    const int blockStride = vertexCountPerBlock * attributesPerVertex;
-    const int maxTreeHeight = 7; // 树木最大高度
-    const int GPUBufferLimit = 1024; // GPU缓冲区大小限制 MB
+    const int uploadBudget = 4;  // 每帧最多上传到 GPU 的区块数
     int worldWidth, worldHeight, worldDepth; // 地图的最大尺寸
     int worldSeed; // 地图种子
     ParticleSystem particleSystem; // 粒子系统
     TextureManager textureManager; // 纹理管理器
-    std::vector<std::vector<std::vector<int>>> map; // 方块类型的3D数组
-    std::vector<std::vector<std::vector<bool>>> visibleBlocks;
+    ChunkGrid grid; // 按区块存储的方块数据
+    ChunkCompressor chunkCompressor; // 在内存中压缩长时间未访问的区块
+    VoxelOccupancy occupancy;        // 8x8x8 砖块的占用表, 批量射线查询用来跳过空气
+    LightEngine lighting;            // 逐方块的天空光和方块光, 构建网格时计算, 编辑时增量更新
+    std::vector<glm::ivec2> lightRemesh;      // 光照改变的区块
+    std::vector<uint8_t> remeshLight;         // 主线程重建网格时拼出的光照 (见 LightEngine::gatherPadded)
+    std::atomic<long long> lightComputeNanos{0}; // 构建网格时计算区块光照的累计耗时
+    EntitySystem entities;           // 生物、掉落物等实体, 随玩家的模拟步推进
+    BlockTickScheduler blockTicks;   // 方块更新调度 (如沙子下落), 随玩家的模拟步推进
+    FluidSimulation fluids;          // 水流元胞自动机, 每 fluidStepInterval 个模拟步推进一次
+    std::vector<FluidSimulation::Change> fluidChanges;
+    PathService paths;               // 分层寻路服务 (生物 AI), 请求在模拟步中批量并行处理
+    const int fluidStepInterval = 12;         // 60Hz 的模拟步下水流每秒扩散 5 格
+    double worldTickMs = 0.0;        // 上一个模拟步 (方块更新和实体) 的耗时
+    const int gravityBlockDelay = 2;          // 沙子下方变空后多少步开始下落
+    const float fallingBlockSize = 0.98f;     // 下落的方块实体的边长
+
+    // 区块在 GPU 上的网格
+    struct ChunkMesh {
+        GLuint VAO = 0, VBO = 0;
+        int vertexCount = 0;
+    };
+    std::vector<ChunkMesh> chunkMeshes;
+    ChunkMesh entityMesh;                   // 下落中的方块, 每帧重建
+    std::vector<float> entityVertices;
+
+    // 模拟步内的编辑推迟到步末, 每个区块只重建一次网格
+    bool deferRemesh = false;
+    std::vector<glm::ivec2> deferredRemesh;
+
+    // 各个面相对方块原点的顶点偏移和纹理坐标, 顺序与 dirs 一致
+    static constexpr float cubeFaceVertices[6][6][5] = {
+        // Right face (+x)
+        {{1, 0, 0, 0, 0}, {1, 1, 0, 0, 1}, {1, 1, 1, 1, 1}, {1, 1, 1, 1, 1}, {1, 0, 1, 1, 0}, {1, 0, 0, 0, 0}},
+        // Left face (-x)
+        {{0, 0, 1, 0, 0}, {0, 1, 1, 0, 1}, {0, 1, 0, 1, 1}, {0, 1, 0, 1, 1}, {0, 0, 0, 1, 0}, {0, 0, 1, 0, 0}},
+        // Top face (+y)
+        {{0, 1, 0, 0, 0}, {0, 1, 1, 0, 1}, {1, 1, 1, 1, 1}, {1, 1, 1, 1, 1}, {1, 1, 0, 1, 0}, {0, 1, 0, 0, 0}},
+        // Bottom face (-y)
+        {{0, 0, 0, 0, 0}, {1, 0, 0, 1, 0}, {1, 0, 1, 1, 1}, {1, 0, 1, 1, 1}, {0, 0, 1, 0, 1}, {0, 0, 0, 0, 0}},
+        // Back face (+z)
+        {{0, 0, 1, 0, 0}, {1, 0, 1, 1, 0}, {1, 1, 1, 1, 1}, {1, 1, 1, 1, 1}, {0, 1, 1, 0, 1}, {0, 0, 1, 0, 0}},
+        // Front face (-z)
+        {{0, 0, 0, 0, 0}, {0, 1, 0, 0, 1}, {1, 1, 0, 1, 1}, {1, 1, 0, 1, 1}, {1, 0, 0, 1, 0}, {0, 0, 0, 0, 0}},
+    };
 
-    GLuint VAO, VBO;  
     Shader world_shader;    // 着色器
 
     Wireframe wireframe;
 
-    std::vector<int> blockVAOIndices;  // 方块在 VAO 中的位置
-    std::vector<int> airIndices;      // 空气方块的 VAO 索引池
-    int vaoSize = 0;                  // 当前 VAO 中的有效方块数量
+    WorldGenerator generator; // 地形生成器
+    ChunkCache chunkCache;    // 磁盘上的区块缓存 (按种子, 可由 worldtool 预先生成)
+    std::atomic<long long> chunksLoaded{0}; // 从缓存载入的区块数
+    static const int meshVersion = 3;         // 网格生成器版本, buildChunkMesh 的输出改变时递增, 使旧的网格缓存失效
+    MeshCache meshCache;                      // 磁盘上的网格缓存 (与区块缓存放在同一目录)
+    mutable SectionMeshCache sectionMeshes;   // 内容相同的段共用的网格 (内存中, 见 buildChunkMesh)
+    std::atomic<long long> meshHitNanos{0};   // 网格缓存命中时计算键和查找的累计耗时
+    std::atomic<long long> meshMissNanos{0};  // 未命中时计算键、构建网格和写入缓存的累计耗时
+    WorldSave worldSave;      // 玩家存档 (被修改过的区块和修改日志, 后台自动保存)
+
+    ChunkPipeline pipeline; // 区块流水线 (须在其引用的数据之后声明)
+
+    // 预取效果统计: 视野内本应可见的区块仍未就绪的帧数
+    long long renderedFrames = 0;
+    long long framesWithMissingChunks = 0;
+    int missingChunks = 0; // 上一帧缺失的区块数
+    std::atomic<long long> stampsPasted{0}; // 装饰阶段粘贴的结构模板数
+
+    const float reachDistance = 7.0f; // 选取方块的最大距离
 
     const int dirs[6][3] = {
         { 1,  0,  0},  // +x
@@ -49,9 +120,8 @@ public:
         { 0,  0, -1},  // -z
     };
 
-    World(int w, int h, int d) : worldWidth(w), worldHeight(h), worldDepth(d),particleSystem(textureManager) {
-        map.resize(worldWidth, std::vector<std::vector<int>>(worldHeight, std::vector<int>(worldDepth, 0)));
-        visibleBlocks.resize(worldWidth, std::vector<std::vector<bool>>(worldHeight, std::vector<bool>(worldDepth, false)));
+    World(int w, int h, int d, int seed) : worldWidth(w), worldHeight(h), worldDepth(d), worldSeed(seed), particleSystem(textureManager), grid(w, h, d), chunkCompressor(grid), occupancy(w, h, d), lighting(grid), blockTicks(grid.chunksX, grid.chunksZ, h), fluids(grid, 0), paths(grid), generator(worldSeed, w, h, d), chunkCache("cache", worldSeed, h, WorldGenerator::version), meshCache(chunkCache.getDirectory() + "/meshes.pack", meshVersion), worldSave("saves", worldSeed, grid), pipeline(grid) {
+        chunkMeshes.resize(grid.chunks.size());
 
         // 初始化着色器、纹理
         world_shader.createProgram("shaders/World.vert", "shaders/World.frag");
@@ -61,203 +131,153 @@ public:
         glBindTexture(GL_TEXTURE_2D_ARRAY, textureManager.getTextureArrayID());
         world_shader.setUniform1i("textureArray", 0);
         
-        // 生成随机种子
-        srand(time(nullptr));
-        worldSeed = rand32();
-        srand(worldSeed);
         std::cout << "[INFO] World Seed: " << worldSeed << std::endl;
 
-        blockVAOIndices.resize(worldWidth * worldHeight * worldDepth, -1); 
+        pipeline.loadStage = [this](Chunk& chunk) {
+            if (worldSave.load(chunk)) return true; // 玩家修改过的区块优先从存档载入
+            if (!chunkCache.load(chunk)) return false;
+            worldSave.applyJournal(chunk);
+            chunksLoaded++;
+            return true;
+        };
+        pipeline.generateStage = [this](Chunk& chunk) { generator.generateChunk(chunk); };
+        pipeline.decorateStage = [this](Chunk& chunk) {
+            stampsPasted += generator.decorateChunk(grid, chunk);
+            chunkCache.save(chunk); // 装饰后区块只含生成结果, 写入缓存供下次启动直接载入
+            worldSave.applyJournal(chunk); // 上次崩溃前未保存的修改
+        };
+        pipeline.meshStage = [this](Chunk& chunk) {
+            occupancy.build(chunk, worldHeight); // 周围区块都已装饰完, 方块数据之后只会因编辑而改变
+            auto lightStart = std::chrono::steady_clock::now();
+            std::vector<uint8_t> light;
+            lighting.computeChunk(chunk, light);
+            auto start = std::chrono::steady_clock::now();
+            lightComputeNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(start - lightStart).count();
+            uint64_t key = meshKey(chunk, light);
+            if (meshCache.lookup(key, chunk.cachedMesh, chunk.cachedMeshFloats)) {
+                meshHitNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+                return;
+            }
+            chunk.meshVertices = buildChunkMesh(chunk, light);
+            meshCache.store(key, chunk.meshVertices);
+            meshMissNanos += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        };
+        std::cout << "[INFO] Chunk pipeline threads: " << pipeline.threadCount() << std::endl;
+        std::cout << "[INFO] Chunk cache: " << chunkCache.getDirectory() << std::endl;
+        std::cout << "[INFO] World save: " << worldSave.getDirectory() << std::endl;
+        worldSave.start();
     }
 
     ~World() {
-        glDeleteVertexArrays(1, &VAO);
-        glDeleteBuffers(1, &VBO);
+        pipeline.stop();
+        worldSave.stop(); // 保存剩余的脏区块
+        for (auto& mesh : chunkMeshes) {
+            releaseChunkMesh(mesh);
+        }
+        releaseChunkMesh(entityMesh);
     }
 
         // 设置某个位置的方块类型
     void setBlock(int x, int y, int z, BlockType type) {
-        if (x >= 0 && x < worldWidth && y >= 0 && y < worldHeight && z >= 0 && z < worldDepth) {
-            map[x][y][z] = type;
+        recordBlock(x, y, z, type);
+        fluids.activate(x, y, z); // 相邻的水可能流入或断流
+    }
+
+    // 写入方块并通知依赖它的系统 (存档、光照、占用表、实体、寻路、重力方块); 水流模拟自己产生的变化也经由这里
+    void recordBlock(int x, int y, int z, BlockType type) {
+        worldSave.setBlock(x, y, z, type); // 同时标记区块为脏并记录到日志
+        lighting.update(x, y, z, lightRemesh);
+        for (const glm::ivec2& chunk : lightRemesh) {
+            remeshChunk(chunk.x, chunk.y);
+        }
+        lightRemesh.clear();
+        if (type != BlockType::BLOCK_AIR && grid.isInsideWorld(x, y, z)) occupancy.markSolid(x, y, z);
+        entities.wakeInBox(glm::vec3(x, y, z), glm::vec3(x + 1, y + 1, z + 1)); // 脚下的方块被挖掉时休眠的实体应掉落
+        paths.invalidate(x, z);
+        notifyNeighbors(x, y, z);
+    }
+
+    // 方块被修改后, 为它自己和相邻的 6 个方块中受重力影响的方块登记更新
+    void notifyNeighbors(int x, int y, int z) {
+        if (isGravityBlock(getBlock(x, y, z))) blockTicks.schedule(x, y, z, gravityBlockDelay);
+        for (const auto& dir : dirs) {
+            int nx = x + dir[0], ny = y + dir[1], nz = z + dir[2];
+            if (isGravityBlock(getBlock(nx, ny, nz))) blockTicks.schedule(nx, ny, nz, gravityBlockDelay);
         }
     }
 
     // 获取某个位置的方块类型
     BlockType getBlock(int x, int y, int z) const {
-        if (x >= 0 && x < worldWidth && y >= 0 && y < worldHeight && z >= 0 && z < worldDepth) {
-            return static_cast<BlockType>(map[x][y][z]);
-        }
-        return BlockType::BLOCK_AIR;
+        return grid.getBlock(x, y, z);
     }
 
-    void generateWorldMap() {
-        FastNoiseLite terrainNoise;
-        terrainNoise.SetNoiseType(FastNoiseLite::NoiseType_Perlin);
-        terrainNoise.SetFrequency(0.03f);
-        int terrainSeed = rand32();
-        terrainNoise.SetSeed(terrainSeed);
-
-        FastNoiseLite biomeNoise;
-        biomeNoise.SetNoiseType(FastNoiseLite::NoiseType_Perlin);
-        biomeNoise.SetFrequency(0.01f);
-        biomeNoise.SetSeed(rand32());
-
-        FastNoiseLite dirtNoise;
-        dirtNoise.SetNoiseType(FastNoiseLite::NoiseType_Perlin);
-        dirtNoise.SetFrequency(0.15f);
-        dirtNoise.SetSeed(rand32());
-
-        // 初始化高度数组
-        std::vector<std::vector<int>> heightMap(worldWidth, std::vector<int>(worldDepth, 0));
-
-        // 第一步：生成原始地形高度
-        for (int x = 0; x < worldWidth; ++x) {
-            for (int z = 0; z < worldDepth; ++z) {
-                float terrainValue = terrainNoise.GetNoise((float)x, (float)z);
-                float normalizedTerrain = (terrainValue + 1.0f) / 2.0f;
-
-                float biomeValue = biomeNoise.GetNoise((float)x, (float)z);
-                bool isBasin = biomeValue > 0.2f;
-
-                int terrainHeight = isBasin
-                    ? (int)(normalizedTerrain * (worldHeight / 4 - 1)) + 1 // [1, worldHeight/4]
-                    : (int)(normalizedTerrain * (worldHeight - 1)) + 1;    // [1, worldHeight]
-
-                terrainHeight = std::max(terrainHeight, 1);
-                heightMap[x][z] = terrainHeight;
-            }
+    // 该列所在区块的方块数据是否已完整 (地形和树木都已生成), 世界外视为完整
+    bool isColumnReady(int x, int z) const {
+        if (x < 0 || x >= worldWidth || z < 0 || z >= worldDepth) {
+            return true;
         }
+        return grid.getChunk(x / CHUNK_SIZE, z / CHUNK_SIZE)->state.load(std::memory_order_acquire) >= CHUNK_DECORATED;
+    }
 
-        // 第二步：平滑地形高度
-        const int maxDelta = 2; // 相邻高度的最大差值
-        const int iterations = 4; // 平滑扫描次数
-
-        for (int iter = 0; iter < iterations; ++iter) {
-            std::vector<std::vector<int>> newHeightMap = heightMap; // 临时存储新的高度值
-
-            for (int x = 1; x < worldWidth - 1; ++x) {
-                for (int z = 1; z < worldDepth - 1; ++z) {
-                    int& currentHeight = heightMap[x][z];
-
-                    for (int dx = -1; dx <= 1; ++dx) {
-                        for (int dz = -1; dz <= 1; ++dz) {
-                            if (dx == 0 && dz == 0) continue;
-
-                            int neighborHeight = heightMap[x + dx][z + dz];
-                            if (currentHeight < neighborHeight - maxDelta) {
-                                // 只调整较低点，提升到允许范围内
-                                newHeightMap[x][z] = currentHeight + (neighborHeight - currentHeight) / 2;
-                            }
-                        }
-                    }
-                }
-            }
-
-            // 更新原始高度图
-            heightMap = newHeightMap;
-        }
-
-        // 第三步：生成方块和树
-        for (int x = 0; x < worldWidth; ++x) {
-            for (int z = 0; z < worldDepth; ++z) {
-                int terrainHeight = heightMap[x][z];
-                float dirtValue = dirtNoise.GetNoise((float)x, (float)z);
-                int dirtDepth = (int)((dirtValue + 1.0f) / 2.0f * terrainHeight / 2) + maxDelta; // [maxDelta, terrainHeight/2 + maxDelta]
-
-                for (int y = 0; y < worldHeight; ++y) {
-                    if (y < terrainHeight) {
-                        if (y == terrainHeight - 1) {
-                            setBlock(x, y, z, BlockType::GRASS_BLOCK);
-                        } else if (y >= terrainHeight - dirtDepth) {
-                            setBlock(x, y, z, BlockType::DIRT_BLOCK);
-                        } else {
-                            setBlock(x, y, z, BlockType::STONE_BLOCK);
-                        }
-                    }
-                }
-
-                float biomeValue = biomeNoise.GetNoise((float)x, (float)z);
-                bool isBasin = biomeValue > 0.2f;
-                if (!isBasin) {
-                    const float treeDensity = 0.001f;
-                    if (rand32() % 10000 < treeDensity * 10000) {
-                        if (canPlaceTree(x, z, terrainHeight)) {
-                            placeTree(x, terrainHeight, z);
-                        }
+    // 加载出生点附近的区块, 阻塞直到玩家脚下的区块可以渲染
+    void generateWorldMap(const glm::vec3& spawnPos) {
+        std::cout << "[INFO] Loading spawn area..." << std::endl;
+        const int spawnRadius = 2;
+        int scx = (int)spawnPos.x / CHUNK_SIZE;
+        int scz = (int)spawnPos.z / CHUNK_SIZE;
+        while (true) {
+            update(spawnPos, glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f));
+            bool ready = true;
+            for (int cx = scx - spawnRadius; cx <= scx + spawnRadius; ++cx) {
+                for (int cz = scz - spawnRadius; cz <= scz + spawnRadius; ++cz) {
+                    Chunk* chunk = grid.getChunk(cx, cz);
+                    if (chunk && chunk->state.load() < CHUNK_UPLOADED) {
+                        ready = false;
                     }
                 }
             }
+            if (ready) break;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
         }
-
-        setupBuffers();
+        std::cout << "[INFO] Mesh cache: " << meshCache.hits.load() << " / " << meshCache.lookups.load()
+                  << " hits, saved ~" << meshCacheSavedMs() << " ms of meshing; section meshes reused "
+                  << sectionMeshes.hits.load() << " / " << sectionMeshes.lookups.load() << std::endl;
     }
 
+    // 网格缓存节省的时间估计: 命中数 x 未命中时的平均耗时 - 命中时的耗时
+    double meshCacheSavedMs() const {
+        long long hits = meshCache.hits.load(), misses = meshCache.lookups.load() - hits;
+        if (misses == 0) return 0.0; // 还没有可参照的构建耗时
+        return hits * (meshMissNanos.load() / 1e6 / misses) - meshHitNanos.load() / 1e6;
+    }
 
-    void setupBuffers() {
-        std::cout << "[INFO] Setting up buffers..." << std::endl;
-        const int maxVertices = worldWidth * worldHeight * worldDepth * vertexCountPerBlock * attributesPerVertex;
-        std::vector<float> vertices; // 用于存储可见方块的顶点数据（临时使用）
-
-        // 遍历方块，生成可见方块的顶点数据
-        for (int x = 0; x < worldWidth; ++x) {
-            for (int y = 0; y < worldHeight; ++y) {
-                for (int z = 0; z < worldDepth; ++z) {
-                    if (isBlockVisible(x, y, z)) {
-                        visibleBlocks[x][y][z] = true;
-
-                        // 添加方块顶点数据
-                        BlockType blockType = getBlock(x, y, z);
-                        std::vector<float> cubeVertices = getCubeVertices(x, y, z, blockType);
-                        vertices.insert(vertices.end(), cubeVertices.begin(), cubeVertices.end());
-
-                        // 更新 VAO 索引
-                        int blockIndex = x * worldHeight * worldDepth + y * worldDepth + z;
-                        blockVAOIndices[blockIndex] = vaoSize++;
-                    } else {
-                        visibleBlocks[x][y][z] = false;
-                    }
-                }
+    // 每帧在主线程调用: 推进区块流水线, 上传网格, 卸载远处区块的网格
+    void update(const glm::vec3& playerPos, const glm::vec3& viewDir, const glm::vec3& playerVelocity) {
+        pipeline.update(playerPos, viewDir, playerVelocity);
+
+        for (Chunk* chunk : pipeline.takeUploads(uploadBudget)) {
+            uploadChunkMesh(*chunk);
+            pipeline.finishUpload(*chunk);
+        }
+
+        for (Chunk& chunk : grid.chunks) {
+            int state = chunk.state.load(std::memory_order_acquire);
+            if (state >= CHUNK_MESHED && pipeline.isBeyondCancelRadius(chunk)) {
+                releaseChunkMesh(chunkMeshes[chunk.cx * grid.chunksZ + chunk.cz]);
+                chunk.meshVertices.clear();
+                chunk.meshVertices.shrink_to_fit();
+                chunk.cachedMesh = nullptr;
+                chunk.light.clear(); // 重新构建网格时按当时的方块数据重新计算
+                chunk.light.shrink_to_fit();
+                chunk.state.store(CHUNK_DECORATED, std::memory_order_release);
             }
         }
 
-        // 创建 VAO 和 VBO
-        glGenVertexArrays(1, &VAO);
-        glGenBuffers(1, &VBO);
-
-        glBindVertexArray(VAO);
-
-        // 在 GPU 上分配缓冲区大小，但不从 CPU 上传所有数据
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferData(GL_ARRAY_BUFFER, GPUBufferLimit * 1024 * 1024, nullptr, GL_STATIC_DRAW);
-        
-        // 如果有初始数据，仅上传当前已有的部分
-        if (!vertices.empty()) {
-            glBufferSubData(GL_ARRAY_BUFFER, 0, vertices.size() * sizeof(float), vertices.data());
-        }
-        std::cout << "[INFO] GPU Buffer Limit: " << GPUBufferLimit << " MB" << std::endl;
-        std::cout << "[INFO] GPU Current Buffer size: " << vertices.size() * sizeof(float) / 1024.0 / 1024.0 << " MB" << std::endl;
-        // 设置顶点属性
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
-        glEnableVertexAttribArray(0);
-
-        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
-        glEnableVertexAttribArray(1);
-
-        glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(5 * sizeof(float)));
-        glEnableVertexAttribArray(2);
-
-        glBindVertexArray(0);
-        std::cout << "[INFO] Buffers set up successfully." << std::endl;
+        chunkCompressor.update([this](int index) { return !worldSave.isDirty(index); });
     }
 
-
-    std::vector<float> getCubeVertices(float x, float y, float z, int blockType) {
-        std::vector<float> cubeVertices(blockStride);
-
-        TextureType textureTypeTop;
-        TextureType textureTypeSide; 
-        TextureType textureTypeBottom; 
-
+    // 获取方块三个方向的纹理
+    static void getBlockTextures(int blockType, TextureType& textureTypeTop, TextureType& textureTypeSide, TextureType& textureTypeBottom) {
         if (blockType == BlockType::BLOCK_AIR) { // 空气方块
             textureTypeTop = TextureType::TEXTURE_AIR;
             textureTypeSide = TextureType::TEXTURE_AIR;
@@ -301,159 +321,259 @@ public:
             textureTypeTop = TextureType::TEXTURE_STONE_BRICKS;
             textureTypeSide = TextureType::TEXTURE_STONE_BRICKS;
             textureTypeBottom = TextureType::TEXTURE_STONE_BRICKS;
+        }else if (isWater(static_cast<BlockType>(blockType))) { // 水源和流动的水
+            textureTypeTop = TextureType::TEXTURE_WATER;
+            textureTypeSide = TextureType::TEXTURE_WATER;
+            textureTypeBottom = TextureType::TEXTURE_WATER;
+        }else if (blockType == BlockType::GLOWSTONE) { // 发光方块
+            textureTypeTop = TextureType::TEXTURE_GLOWSTONE;
+            textureTypeSide = TextureType::TEXTURE_GLOWSTONE;
+            textureTypeBottom = TextureType::TEXTURE_GLOWSTONE;
         }
-
-        // 每个面由两个三角形组成，总共36个顶点，每个顶点包含位置(0-2)、纹理坐标(3-4)和材质信息(5)
-        cubeVertices = {
-            // Front face (侧面纹理)
-            x,     y,     z,     0.0f, 0.0f, float(textureTypeSide),
-            x,     y + 1, z,     0.0f, 1.0f, float(textureTypeSide),
-            x + 1, y + 1, z,     1.0f, 1.0f, float(textureTypeSide),
-            x + 1, y + 1, z,     1.0f, 1.0f, float(textureTypeSide),
-            x + 1, y,     z,     1.0f, 0.0f, float(textureTypeSide),
-            x,     y,     z,     0.0f, 0.0f, float(textureTypeSide),
-
-            // Back face (侧面纹理)
-            x,     y,     z + 1, 0.0f, 0.0f, float(textureTypeSide),
-            x + 1, y,     z + 1, 1.0f, 0.0f, float(textureTypeSide),
-            x + 1, y + 1, z + 1, 1.0f, 1.0f, float(textureTypeSide),
-            x + 1, y + 1, z + 1, 1.0f, 1.0f, float(textureTypeSide),
-            x,     y + 1, z + 1, 0.0f, 1.0f, float(textureTypeSide),
-            x,     y,     z + 1, 0.0f, 0.0f, float(textureTypeSide),
-
-            // Left face (侧面纹理)
-            x,     y,     z + 1, 0.0f, 0.0f, float(textureTypeSide),
-            x,     y + 1, z + 1, 0.0f, 1.0f, float(textureTypeSide),
-            x,     y + 1, z,     1.0f, 1.0f, float(textureTypeSide),
-            x,     y + 1, z,     1.0f, 1.0f, float(textureTypeSide),
-            x,     y,     z,     1.0f, 0.0f, float(textureTypeSide),
-            x,     y,     z + 1, 0.0f, 0.0f, float(textureTypeSide),
-
-            // Right face (侧面纹理)
-            x + 1, y,     z,     0.0f, 0.0f, float(textureTypeSide),
-            x + 1, y + 1, z,     0.0f, 1.0f, float(textureTypeSide),
-            x + 1, y + 1, z + 1, 1.0f, 1.0f, float(textureTypeSide),
-            x + 1, y + 1, z + 1, 1.0f, 1.0f, float(textureTypeSide),
-            x + 1, y,     z + 1, 1.0f, 0.0f, float(textureTypeSide),
-            x + 1, y,     z,     0.0f, 0.0f, float(textureTypeSide),
-
-            // Top face (顶部纹理)
-            x,     y + 1, z,     0.0f, 0.0f, float(textureTypeTop),
-            x,     y + 1, z + 1, 0.0f, 1.0f, float(textureTypeTop),
-            x + 1, y + 1, z + 1, 1.0f, 1.0f, float(textureTypeTop),
-            x + 1, y + 1, z + 1, 1.0f, 1.0f, float(textureTypeTop),
-            x + 1, y + 1, z,     1.0f, 0.0f, float(textureTypeTop),
-            x,     y + 1, z,     0.0f, 0.0f, float(textureTypeTop),
-
-            // Bottom face (底部纹理)
-            x,     y,     z,     0.0f, 0.0f, float(textureTypeBottom),
-            x + 1, y,     z,     1.0f, 0.0f, float(textureTypeBottom),
-            x + 1, y,     z + 1, 1.0f, 1.0f, float(textureTypeBottom),
-            x + 1, y,     z + 1, 1.0f, 1.0f, float(textureTypeBottom),
-            x,     y,     z + 1, 0.0f, 1.0f, float(textureTypeBottom),
-            x,     y,     z,     0.0f, 0.0f, float(textureTypeBottom),
-        };
-        return cubeVertices;
-    }
-
-    bool canPlaceTree(int x, int z, int terrainHeight) {
-        const int treeSpacing = 5; // 树木间隔
-
-        // 如果树的顶部超出世界高度，返回 false
-        if (terrainHeight + maxTreeHeight >= worldHeight) {
-            return false;
-        }
-
-        // 遍历以 (x, z) 为中心的间隔范围，检查树木间隔
-        for (int dx = -treeSpacing; dx <= treeSpacing; ++dx) {
-            for (int dz = -treeSpacing; dz <= treeSpacing; ++dz) {
-                if (x + dx >= 0 && x + dx < worldWidth && z + dz >= 0 && z + dz < worldDepth) {
-                    // 检查区域内是否已经有树
-                    for (int y = 0; y < worldHeight; ++y) {
-                        BlockType blockType = getBlock(x + dx, y, z + dz);
-                        if (blockType == BlockType::OAK_LOG || blockType == BlockType::OAK_LEAVES) {
-                            return false; // 如果检测到树干或树叶，返回 false
-                        }
-                    }
-                }
-            }
-        }
-        return true;
     }
 
     /*
-        生成树木
-        x, z: 树木的位置
-        baseHeight: 树底的高度
-        树的总高度: 5/6/7
-        树干高度为树的总高度 - 1
+        构建区块网格 (工作线程或主线程)
+        只输出朝向透明方块的面; 越界的方向视为敞开
+        每个面由两个三角形组成，共6个顶点，每个顶点包含位置(0-2)、纹理坐标(3-4)、材质信息(5)和光照(6)
+        光照取面外侧格子的值 (天空光 * 16 + 方块光), light 为带一圈邻居的区块光照 (见 LightEngine)
+        按段构建: 段的网格只取决于段及外面一圈的方块和光照, 内容相同的段从 sectionMeshes 复用后平移到所在位置
     */
-    void placeTree(int x, int baseHeight, int z) {
-        int treeHeight = 5 + rand() % 3; // 树高度随机在 5 到 7 之间
-        for (int y = baseHeight; y < baseHeight + treeHeight - 1 && y < worldHeight-1; ++y) {
-            setBlock(x, y, z, BlockType::OAK_LOG); // 树干用类型 2 表示
-        }
-
-        if (treeHeight >=6){
-            for (int y = baseHeight + treeHeight -1; y > baseHeight && y> baseHeight + treeHeight - 5 && y < worldHeight; y--){
-                // 顶层树叶 
-                if (y == baseHeight + treeHeight - 1){
-                    for (int dx = x - 1; dx <= x + 1; dx++){
-                        for (int dz = z - 1; dz <= z + 1; dz++){
-                            if (dx == x || dz == z){
-                                setBlock(dx, y, dz, BlockType::OAK_LEAVES);
-                            }
-                        }
+    std::vector<float> buildChunkMesh(const Chunk& chunk, const std::vector<uint8_t>& light) const {
+        const int layerBytes = CHUNK_SIZE * CHUNK_SIZE;
+        const int P = LightEngine::PADDED_SIZE;
+        const std::array<bool, 256>& transparent = transparentTable();
+        std::vector<uint8_t> shell(2 * P * P * (SECTION_HEIGHT + 2)); // 段及外面一圈的方块, 之后是对应的光照
+        // 四周的区块 (-x, +x, -z, +z), 世界外为空 (视为空气); 调用前已解压 3x3 区块
+        const Chunk* neighbors[4] = { grid.getChunk(chunk.cx - 1, chunk.cz), grid.getChunk(chunk.cx + 1, chunk.cz),
+                                      grid.getChunk(chunk.cx, chunk.cz - 1), grid.getChunk(chunk.cx, chunk.cz + 1) };
+
+        int x0 = chunk.cx * CHUNK_SIZE, z0 = chunk.cz * CHUNK_SIZE;
+        int sectionCount = (worldHeight + SECTION_HEIGHT - 1) / SECTION_HEIGHT;
+        std::vector<SectionMeshCache::Mesh> meshes(sectionCount);
+        size_t totalFloats = 0;
+        for (int y0 = 0; y0 < worldHeight; y0 += SECTION_HEIGHT) {
+            int height = std::min(SECTION_HEIGHT, worldHeight - y0);
+            const uint8_t* section = chunk.blocks.data() + y0 * layerBytes;
+            if (std::all_of(section, section + height * layerBytes, [](uint8_t block) { return block == BlockType::BLOCK_AIR; })) continue; // 全空气的段没有面
+
+            // 只有与段共面的一圈邻居会被读到, 棱和角上的格子保持 0; 不透明格子的光照不会被读到, 也保持 0, 以便更多的段内容相同
+            int cells = P * P * (height + 2);
+            uint8_t* blocks = shell.data();
+            uint8_t* faceLight = blocks + cells;
+            std::fill(shell.begin(), shell.begin() + 2 * cells, 0);
+            for (int py = 0; py < height + 2; ++py) {
+                int y = y0 + py - 1;
+                bool cap = py == 0 || py == height + 1; // 段上下的一层只需要正对段的部分
+                if (y < 0 || y >= worldHeight) { // 世界外为空气, 上方视为露天
+                    if (y >= worldHeight) {
+                        for (int lz = 0; lz < CHUNK_SIZE; ++lz) std::memset(faceLight + LightEngine::paddedIndex(1, py, lz + 1), LightEngine::FULL_SKY, CHUNK_SIZE);
                     }
+                    continue;
                 }
-                // 2层
-                else if (y == baseHeight + treeHeight - 2){
-                    for (int dx = x - 1; dx <= x + 1; dx++){
-                        for(int dz= z - 1; dz <= z + 1; dz++){
-                            // 躲避树干
-                            if (dx != x || dz != z){
-                                setBlock(dx, y, dz, BlockType::OAK_LEAVES);
-                            }
-                        }
+                for (int lz = 0; lz < CHUNK_SIZE; ++lz) {
+                    std::memcpy(blocks + LightEngine::paddedIndex(1, py, lz + 1), chunk.blocks.data() + ChunkGrid::blockIndex(0, y, lz), CHUNK_SIZE);
+                }
+                if (!cap) {
+                    for (int i = 0; i < CHUNK_SIZE; ++i) {
+                        if (neighbors[0]) blocks[LightEngine::paddedIndex(0, py, i + 1)] = neighbors[0]->blocks[ChunkGrid::blockIndex(CHUNK_SIZE - 1, y, i)];
+                        if (neighbors[1]) blocks[LightEngine::paddedIndex(P - 1, py, i + 1)] = neighbors[1]->blocks[ChunkGrid::blockIndex(0, y, i)];
+                        if (neighbors[2]) blocks[LightEngine::paddedIndex(i + 1, py, 0)] = neighbors[2]->blocks[ChunkGrid::blockIndex(i, y, CHUNK_SIZE - 1)];
+                        if (neighbors[3]) blocks[LightEngine::paddedIndex(i + 1, py, P - 1)] = neighbors[3]->blocks[ChunkGrid::blockIndex(i, y, 0)];
                     }
                 }
-                // 34层
-                else if (y < baseHeight + treeHeight - 2){
-                    for (int dx = x - 2; dx <= x + 2; dx++){
-                        for(int dz= z - 2; dz <= z + 2; dz++){
-                            if (dx != x || dz != z){
-                                setBlock(dx, y, dz, BlockType::OAK_LEAVES);
-                            }
-                        }
+                for (int pz = 0; pz < P; ++pz) {
+                    bool edgeZ = pz == 0 || pz == P - 1;
+                    for (int px = 0; px < P; ++px) {
+                        bool edgeX = px == 0 || px == P - 1;
+                        if ((edgeX && edgeZ) || (cap && (edgeX || edgeZ))) continue;
+                        int index = LightEngine::paddedIndex(px, py, pz);
+                        if (transparent[blocks[index]]) faceLight[index] = light[LightEngine::paddedIndex(px, y, pz)];
                     }
                 }
             }
+
+            uint64_t key = SectionMeshCache::hashKey(shell.data(), 2 * cells, ((uint64_t)meshVersion << 32) | (uint32_t)height);
+            SectionMeshCache::Mesh mesh = sectionMeshes.lookup(key);
+            if (!mesh) {
+                mesh = std::make_shared<const std::vector<float>>(buildSectionMesh(blocks, faceLight, height));
+                sectionMeshes.store(key, mesh);
+            }
+            meshes[y0 / SECTION_HEIGHT] = mesh;
+            totalFloats += mesh->size();
+        }
+
+        // 把各段的网格平移到所在位置后拼接
+        std::vector<float> vertices(totalFloats);
+        float* out = vertices.data();
+        for (int sy = 0; sy < sectionCount; ++sy) {
+            if (!meshes[sy]) continue;
+            float y0 = float(sy * SECTION_HEIGHT);
+            std::memcpy(out, meshes[sy]->data(), meshes[sy]->size() * sizeof(float));
+            for (float* end = out + meshes[sy]->size(); out < end; out += 7) {
+                out[0] += x0;
+                out[1] += y0;
+                out[2] += z0;
+            }
         }
-        else if (treeHeight == 5) { 
-            for (int y = baseHeight + treeHeight -1; y > baseHeight && y> baseHeight + treeHeight - 4 && y < worldHeight; y--){
-                // 顶层树叶 
-                if (y == baseHeight + treeHeight - 1){
-                    for (int dx = x - 1; dx <= x + 1; dx++){
-                        for (int dz = z - 1; dz <= z + 1; dz++){
-                            if (dx == x || dz == z){
-                                setBlock(dx, y, dz, BlockType::OAK_LEAVES);
-                            }
-                        }
-                    }
-                }
-                // 23层
-                else if (y <= baseHeight + treeHeight - 2){
-                    for (int dx = x - 2; dx <= x + 2; dx++){
-                        for(int dz= z - 2; dz <= z + 2; dz++){
-                            // 躲避树干
-                            if (dx != x || dz != z){
-                                setBlock(dx, y, dz, BlockType::OAK_LEAVES);
-                            }
+        return vertices;
+    }
+
+    // 按方块类型查表的 isTransparent, 构建网格时每个格子都要查询
+    static const std::array<bool, 256>& transparentTable() {
+        static const std::array<bool, 256> table = [] {
+            std::array<bool, 256> result{};
+            for (int type = 0; type < 256; ++type) result[type] = isTransparent(static_cast<BlockType>(type));
+            return result;
+        }();
+        return table;
+    }
+
+    // 构建一段的网格, 顶点使用段内坐标; blocks 和 faceLight 为段及外面一圈的方块和光照 (下标见 LightEngine::paddedIndex)
+    std::vector<float> buildSectionMesh(const uint8_t* blocks, const uint8_t* faceLight, int height) const {
+        const std::array<bool, 256>& transparent = transparentTable();
+        std::vector<float> vertices;
+        for (int y = 0; y < height; ++y) {
+            for (int lz = 0; lz < CHUNK_SIZE; ++lz) {
+                for (int lx = 0; lx < CHUNK_SIZE; ++lx) {
+                    int blockType = blocks[LightEngine::paddedIndex(lx + 1, y + 1, lz + 1)];
+                    if (blockType == BlockType::BLOCK_AIR) continue;
+
+                    TextureType textureTypeTop = TEXTURE_AIR, textureTypeSide = TEXTURE_AIR, textureTypeBottom = TEXTURE_AIR;
+                    getBlockTextures(blockType, textureTypeTop, textureTypeSide, textureTypeBottom);
+
+                    for (int face = 0; face < 6; ++face) {
+                        int neighbor = LightEngine::paddedIndex(lx + 1 + dirs[face][0], y + 1 + dirs[face][1], lz + 1 + dirs[face][2]);
+                        BlockType neighborType = static_cast<BlockType>(blocks[neighbor]);
+                        if (!transparent[neighborType]) continue;
+                        if (isWater(static_cast<BlockType>(blockType)) && isWater(neighborType)) continue; // 水体内部的面
+
+                        float texture = float(face == 2 ? textureTypeTop : face == 3 ? textureTypeBottom : textureTypeSide);
+                        size_t offset = vertices.size();
+                        vertices.resize(offset + 6 * 7);
+                        float* out = vertices.data() + offset;
+                        for (const auto& v : cubeFaceVertices[face]) {
+                            *out++ = lx + v[0]; *out++ = y + v[1]; *out++ = lz + v[2];
+                            *out++ = v[3]; *out++ = v[4]; *out++ = texture; *out++ = float(faceLight[neighbor]);
                         }
                     }
                 }
             }
         }
+        return vertices;
+    }
+
+    /*
+        网格缓存的键: 网格生成器版本、区块坐标 (顶点使用世界坐标)、区块的方块数据,
+        四个相邻区块贴着边界的一层方块 (buildChunkMesh 只会读到这些方块), 以及带一圈邻居的光照; 调用前已解压 3x3 区块
+    */
+    uint64_t meshKey(const Chunk& chunk, const std::vector<uint8_t>& light) const {
+        int32_t header[4] = { meshVersion, chunk.cx, chunk.cz, worldHeight };
+        uint64_t hash = SectionStore::hashBytes(reinterpret_cast<const uint8_t*>(header), sizeof(header));
+        hash = SectionStore::hashBytes(chunk.blocks.data(), chunk.blocks.size(), hash);
+
+        std::vector<uint8_t> border(4 * CHUNK_SIZE * worldHeight);
+        int x0 = chunk.cx * CHUNK_SIZE, z0 = chunk.cz * CHUNK_SIZE;
+        size_t offset = 0;
+        for (int y = 0; y < worldHeight; ++y) {
+            for (int i = 0; i < CHUNK_SIZE; ++i) {
+                border[offset++] = grid.getResidentBlock(x0 - 1, y, z0 + i);
+                border[offset++] = grid.getResidentBlock(x0 + CHUNK_SIZE, y, z0 + i);
+                border[offset++] = grid.getResidentBlock(x0 + i, y, z0 - 1);
+                border[offset++] = grid.getResidentBlock(x0 + i, y, z0 + CHUNK_SIZE);
+            }
+        }
+        hash = SectionStore::hashBytes(border.data(), border.size(), hash);
+        return SectionStore::hashBytes(light.data(), light.size(), hash);
+    }
+
+    // 上传区块网格到 GPU (主线程)
+    // 创建网格的顶点数组和缓冲区 (顶点格式见 buildChunkMesh)
+    void createMeshBuffers(ChunkMesh& mesh) {
+        glGenVertexArrays(1, &mesh.VAO);
+        glGenBuffers(1, &mesh.VBO);
+
+        glBindVertexArray(mesh.VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+
+        // 设置顶点属性
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 7 * sizeof(float), (void*)0);
+        glEnableVertexAttribArray(0);
+
+        glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 7 * sizeof(float), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(1);
+
+        glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, 7 * sizeof(float), (void*)(5 * sizeof(float)));
+        glEnableVertexAttribArray(2);
+
+        glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, 7 * sizeof(float), (void*)(6 * sizeof(float)));
+        glEnableVertexAttribArray(3);
+
+        glBindVertexArray(0);
+    }
+
+    void uploadChunkMesh(Chunk& chunk) {
+        ChunkMesh& mesh = chunkMeshes[chunk.cx * grid.chunksZ + chunk.cz];
+        if (mesh.VAO == 0) {
+            createMeshBuffers(mesh);
+        }
+
+        // 网格缓存命中时直接从映射的缓存文件上传, 不经过 meshVertices
+        const float* vertices = chunk.cachedMesh ? chunk.cachedMesh : chunk.meshVertices.data();
+        size_t floatCount = chunk.cachedMesh ? chunk.cachedMeshFloats : chunk.meshVertices.size();
+        glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+        glBufferData(GL_ARRAY_BUFFER, floatCount * sizeof(float), vertices, GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        mesh.vertexCount = floatCount / 7;
+
+        chunk.meshVertices.clear();
+        chunk.meshVertices.shrink_to_fit();
+        chunk.cachedMesh = nullptr;
+    }
+
+    void releaseChunkMesh(ChunkMesh& mesh) {
+        if (mesh.VAO != 0) {
+            glDeleteVertexArrays(1, &mesh.VAO);
+            glDeleteBuffers(1, &mesh.VBO);
+        }
+        mesh = ChunkMesh();
+    }
+
+    // 编辑后立即重建区块网格 (主线程)
+    void remeshChunk(int cx, int cz) {
+        Chunk* chunk = grid.getChunk(cx, cz);
+        if (!chunk) return;
+        if (deferRemesh) {
+            deferredRemesh.push_back(glm::ivec2(cx, cz));
+            return;
+        }
+        int state = chunk->state.load(std::memory_order_acquire);
+        if (state >= CHUNK_MESHED) grid.unpackAround(cx, cz); // 边缘的邻居可能已被压缩
+        if (state >= CHUNK_MESHED) lighting.gatherPadded(*chunk, remeshLight);
+        if (state == CHUNK_MESHED) {
+            chunk->meshVertices = buildChunkMesh(*chunk, remeshLight); // 尚未上传, 上传阶段会使用新网格
+            chunk->cachedMesh = nullptr;
+        } else if (state >= CHUNK_UPLOADED) {
+            chunk->meshVertices = buildChunkMesh(*chunk, remeshLight);
+            uploadChunkMesh(*chunk);
+        }
+    }
+
+    // 重建方块所在区块, 以及方块位于边界时相邻的区块
+    void remeshAround(int x, int z) {
+        int cx = x / CHUNK_SIZE, cz = z / CHUNK_SIZE;
+        int lx = x % CHUNK_SIZE, lz = z % CHUNK_SIZE;
+        remeshChunk(cx, cz);
+        if (lx == 0) remeshChunk(cx - 1, cz);
+        if (lx == CHUNK_SIZE - 1) remeshChunk(cx + 1, cz);
+        if (lz == 0) remeshChunk(cx, cz - 1);
+        if (lz == CHUNK_SIZE - 1) remeshChunk(cx, cz + 1);
+    }
+
+    // 只有周围 3x3 区块都已构建网格时才允许编辑, 避免与工作线程同时读写
+    bool canEditBlock(int x, int y, int z) const {
+        if (!grid.isInsideWorld(x, y, z)) return false;
+        return grid.neighborsReached(x / CHUNK_SIZE, z / CHUNK_SIZE, CHUNK_MESHED);
     }
 
     // 渲染地图
@@ -465,70 +585,158 @@ public:
         world_shader.setUniformMatrix4fv("projection", glm::value_ptr(projection));
         world_shader.setUniform1f("dayNightBlendFactor", DayTime::getDayNightBlendFactor());
 
-        glBindVertexArray(VAO);
+        // 从投影矩阵中提取视锥体的左、右、下、上、近平面 (无穷远投影没有远平面)
+        glm::mat4 viewProjection = projection * view;
+        glm::vec4 planes[5];
+        for (int i = 0; i < 2; ++i) {
+            for (int sign = 0; sign < 2; ++sign) {
+                glm::vec4& plane = planes[i * 2 + sign];
+                for (int col = 0; col < 4; ++col) {
+                    plane[col] = viewProjection[col][3] + (sign == 0 ? 1.0f : -1.0f) * viewProjection[col][i];
+                }
+            }
+        }
+        for (int col = 0; col < 4; ++col) {
+            planes[4][col] = viewProjection[col][3] + viewProjection[col][2];
+        }
+
+        // 加载半径最外两圈只用于装饰和网格构建, 不计入缺失
+        const float requiredRadius = pipeline.loadRadius - 2.0f;
+        missingChunks = 0;
+
+        for (Chunk& chunk : grid.chunks) {
+            int state = chunk.state.load(std::memory_order_acquire);
+            bool ready = state >= CHUNK_UPLOADED;
+            if (!ready && pipeline.chunkDistance(chunk.cx, chunk.cz) > requiredRadius) continue;
+
+            // 视锥裁剪: 区块包围盒完全在某个平面外侧则不可见
+            glm::vec3 boxMin(chunk.cx * CHUNK_SIZE, 0.0f, chunk.cz * CHUNK_SIZE);
+            glm::vec3 boxMax = boxMin + glm::vec3(CHUNK_SIZE, worldHeight, CHUNK_SIZE);
+            bool visible = true;
+            for (const glm::vec4& plane : planes) {
+                glm::vec3 positive(plane.x >= 0 ? boxMax.x : boxMin.x,
+                                   plane.y >= 0 ? boxMax.y : boxMin.y,
+                                   plane.z >= 0 ? boxMax.z : boxMin.z);
+                if (glm::dot(glm::vec3(plane), positive) + plane.w < 0) {
+                    visible = false;
+                    break;
+                }
+            }
+            if (!ready) {
+                if (visible) missingChunks++;
+                continue;
+            }
+            chunk.state.store(visible ? CHUNK_VISIBLE : CHUNK_UPLOADED, std::memory_order_release);
+            if (!visible) continue;
+
+            const ChunkMesh& mesh = chunkMeshes[chunk.cx * grid.chunksZ + chunk.cz];
+            glBindVertexArray(mesh.VAO);
+            // 使用三角形模式绘制
+            glDrawArrays(GL_TRIANGLES, 0, mesh.vertexCount);
+        }
 
-        // 使用三角形模式绘制
-        glDrawArrays(GL_TRIANGLES, 0, vaoSize * vertexCountPerBlock); // 每个方块有6*6=36个顶点
+        renderedFrames++;
+        if (missingChunks > 0) framesWithMissingChunks++;
 
         glBindVertexArray(0);
     }
 
+    // 区块流水线统计 (F3 调试信息)
+    void renderDebugInfo() {
+        int visibleChunks = 0;
+        for (const Chunk& chunk : grid.chunks) {
+            if (chunk.state.load(std::memory_order_relaxed) == CHUNK_VISIBLE) visibleChunks++;
+        }
+
+        ImGui::SetNextWindowPos(ImVec2(10, 10), ImGuiCond_Always);
+        ImGui::SetNextWindowBgAlpha(0.5f);
+        ImGui::Begin("Debug", nullptr, ImGuiWindowFlags_NoTitleBar | ImGuiWindowFlags_NoResize | ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoMove);
+        ImGui::Text("Chunk pipeline (%d threads)", pipeline.threadCount());
+        for (int stage = 0; stage < STAGE_COUNT; ++stage) {
+            StageStats stats = pipeline.getStats(static_cast<PipelineStage>(stage));
+            ImGui::Text("%-8s queued %4d  done %6lld  cancelled %5lld  avg %7.2f ms  max %8.2f ms",
+                pipelineStageNames[stage], stats.queued, stats.completed, stats.cancelled, stats.avgLatencyMs, stats.maxLatencyMs);
+        }
+        StageStats generateStats = pipeline.getStats(STAGE_GENERATE);
+        if (generateStats.totalWorkMs > 0.0) {
+            double columnsPerSecond = generateStats.completed * CHUNK_SIZE * CHUNK_SIZE / (generateStats.totalWorkMs / 1000.0);
+            ImGui::Text("Generate throughput: %.0f columns/s per thread", columnsPerSecond);
+        }
+        StageStats decorateStats = pipeline.getStats(STAGE_DECORATE);
+        if (decorateStats.totalWorkMs > 0.0) {
+            ImGui::Text("Decorate throughput: %.0f stamps/s per thread", stampsPasted.load() / (decorateStats.totalWorkMs / 1000.0));
+        }
+        ImGui::Text("Chunks loaded from cache: %lld", chunksLoaded.load());
+        long long unpackCount = grid.unpackCount.load();
+        ImGui::Text("Cold chunks: %d packed (ratio %.1f), resident %.1f MB, unpacked %lld (avg %.1f us, max %.1f us)",
+            grid.packedChunks.load(), chunkCompressor.compressionRatio(), chunkCompressor.residentBytes() / (1024.0 * 1024.0), unpackCount,
+            unpackCount > 0 ? grid.unpackNanos.load() / 1000.0 / unpackCount : 0.0, grid.maxUnpackNanos.load() / 1000.0);
+        ImGui::Text("Section dedup: hit rate %.1f%% (%lld lookups), %d unique sections, %.1f KB",
+            grid.sectionStore.hitRate() * 100.0f, grid.sectionStore.lookups.load(), grid.sectionStore.uniqueCount(), grid.sectionStore.bytes() / 1024.0);
+        long long meshHits = meshCache.hits.load(), meshMisses = meshCache.lookups.load() - meshHits;
+        ImGui::Text("Mesh cache: hit rate %.1f%% (%lld hits, %lld stored), saved ~%.0f ms (miss avg %.2f ms, hit avg %.3f ms)",
+            meshCache.hitRate() * 100.0f, meshHits, meshCache.stored.load(), meshCacheSavedMs(),
+            meshMisses > 0 ? meshMissNanos.load() / 1e6 / meshMisses : 0.0, meshHits > 0 ? meshHitNanos.load() / 1e6 / meshHits : 0.0);
+        ImGui::Text("Section meshes: reused %.1f%% (%lld lookups)", sectionMeshes.hitRate() * 100.0f, sectionMeshes.lookups.load());
+        ImGui::Text("Autosave: %d dirty chunks, %d journal records, last %d chunks in %.2f ms (replayed %d edits)",
+            worldSave.dirtyChunkCount(), worldSave.journalRecordCount(), worldSave.lastSaveChunks.load(), worldSave.lastSaveMs.load(), worldSave.replayedEdits.load());
+        ImGui::Text("Entities: %d (%d awake, %d contacts), tick %.3f ms", entities.size(), entities.lastAwake, entities.lastContacts, worldTickMs);
+        ImGui::Text("Block ticks: %d last tick, %lld pending, %lld total", blockTicks.lastUpdates, blockTicks.pending(), blockTicks.totalUpdates);
+        ImGui::Text("Fluid: %d active cells in %d chunks, %d changed, step %.3f ms (%lld changes total)",
+            fluids.lastActiveCells, fluids.lastActiveChunks, fluids.lastChanged, fluids.lastStepMs, fluids.totalChanged);
+        ImGui::Text("Paths: %d requests in %.3f ms, %lld / %lld found, %d pending; graph %d chunks, %d regions, last refresh %d chunks in %.2f ms",
+            paths.lastBatchRequests, paths.lastBatchMs, paths.totalFound, paths.totalPaths, (int)paths.pendingCount(),
+            paths.builtChunks(), paths.regionCount(), paths.lastRebuiltChunks, paths.lastRefreshMs);
+        StageStats meshStats = pipeline.getStats(STAGE_MESH);
+        ImGui::Text("Light: last edit %d cells in %.3f ms (avg %.3f ms, max %.3f ms over %lld edits), chunk compute avg %.2f ms",
+            lighting.lastUpdatedCells, lighting.lastUpdateMs, lighting.updates > 0 ? lighting.totalUpdateMs / lighting.updates : 0.0,
+            lighting.maxUpdateMs, lighting.updates, meshStats.completed > 0 ? lightComputeNanos.load() / 1e6 / meshStats.completed : 0.0);
+        ImGui::Text("Visible chunks: %d", visibleChunks);
+        ImGui::Text("Frames with missing chunks: %lld / %lld (missing now: %d)", framesWithMissingChunks, renderedFrames, missingChunks);
+        ImGui::End();
+    }
+
+    // 从 origin 沿 direction 发射射线, 返回第一个非空气方块; 世界外视为空气
+    bool raycast(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, RayHit& hit) const {
+        return raycastVoxels(origin, direction, maxDistance, [this](int x, int y, int z) { return grid.getBlock(x, y, z); }, hit);
+    }
+
+    /*
+        批量射线查询 (视线检测、环境光遮蔽烘焙、命中验证等): hits[i] 为 rays[i] 的结果, 未命中时 type 为空气; 返回命中的射线数
+        用占用表跳过空的砖块, 结果与逐条调用 raycast 相同; 可能解压冷区块, 只在主线程调用
+    */
+    size_t raycastBatch(const std::vector<Ray>& rays, std::vector<RayHit>& hits) const {
+        hits.resize(rays.size());
+        return ::raycastBatch(grid, occupancy, rays.data(), rays.size(), hits.data());
+    }
+
     // 检测选中的方块
     // blockHit: 返回选中的方块的位置
-    bool detectSelectedBlock(const glm::vec3& playerPos, const glm::vec3& rayDir, glm::vec3& blockHit) {
-        float maxDistance = 7.0f; // 最大检测距离
-        float step = 0.1f;          // 每步的移动距离
-
-        for (float distance = 0.0f; distance < maxDistance; distance += step) {
-            glm::vec3 currentPos = playerPos + distance * rayDir;
-            int x = static_cast<int>(currentPos.x);
-            int y = static_cast<int>(currentPos.y);
-            int z = static_cast<int>(currentPos.z);
-
-            if (getBlock(x, y, z) > 0) {
-                blockHit = glm::vec3(x, y, z);
-                return true;
-            }
-        }
-        return false;
+    bool detectSelectedBlock(const glm::vec3& playerPos, const glm::vec3& rayDir, glm::vec3& blockHit) const {
+        RayHit hit;
+        if (!raycast(playerPos, rayDir, reachDistance, hit)) return false;
+        blockHit = glm::vec3(hit.block);
+        return true;
     }
 
-    // 寻找放置方块的位置(选中的非空白方块 前的最后一个 空白方块)
-    bool findLastAirBlock(const glm::vec3& playerPos, const glm::vec3& rayDir, glm::vec3& blockHit) {
-        float maxDistance = 7.0f; // 最大检测距离
-        float step = 0.1f;          // 每步的移动距离
-
-        for (float distance = 0.0f; distance < maxDistance; distance += step) {
-            glm::vec3 currentPos = playerPos + distance * rayDir;
-            int x = static_cast<int>(currentPos.x);
-            int y = static_cast<int>(currentPos.y);
-            int z = static_cast<int>(currentPos.z);
-
-            if (getBlock(x, y, z) > 0) {
-                currentPos = currentPos - step * rayDir;
-                x = static_cast<int>(currentPos.x);
-                y = static_cast<int>(currentPos.y);
-                z = static_cast<int>(currentPos.z);
-                blockHit = glm::vec3(x, y, z);
-                return true;
-            }
-        }
-        return false;
+    // 寻找放置方块的位置: 选中的方块被射线击中的那个面外侧的格子
+    bool findPlacementBlock(const glm::vec3& playerPos, const glm::vec3& rayDir, glm::ivec3& placePos) const {
+        RayHit hit;
+        if (!raycast(playerPos, rayDir, reachDistance, hit) || hit.normal == glm::ivec3(0)) return false; // 起点在方块内时没有可放置的面
+        placePos = hit.block + hit.normal;
+        return true;
     }
 
     void addBlock(int x, int y, int z, BlockType type) {
-        setBlock(x, y, z, type);
-
-        // 更新当前方块和周围邻居的可见性
-        updateVisibility(x, y, z);
-        for (auto& dir : dirs) {
-            updateVisibility(x + dir[0], y + dir[1], z + dir[2]);
+        if (!canEditBlock(x, y, z)) {
+            return;
         }
+        editBlock(x, y, z, type);
     }
 
     void removeBlock(int x, int y, int z) {
         // 检查边界
-        if (x < 0 || x >= worldWidth || y < 0 || y >= worldHeight || z < 0 || z >= worldDepth) {
+        if (!canEditBlock(x, y, z)) {
             return;
         }
 
@@ -543,10 +751,18 @@ public:
         particleSystem.emit(blockCenter, currentType);
 
         // 移除方块数据
-        setBlock(x, y, z, BlockType::BLOCK_AIR);
-        updateVisibility(x, y, z);
-        for (auto& dir : dirs) {
-            updateVisibility(x + dir[0], y + dir[1], z + dir[2]);
+        editBlock(x, y, z, BlockType::BLOCK_AIR);
+    }
+
+    // 修改方块并重建受影响的区块网格; 光照的变化可能波及周围多个区块, 每个区块只重建一次
+    void editBlock(int x, int y, int z, BlockType type) {
+        bool outermost = !deferRemesh; // 模拟步内由 tick 统一重建
+        deferRemesh = true;
+        setBlock(x, y, z, type);
+        remeshAround(x, z);
+        if (outermost) {
+            deferRemesh = false;
+            flushDeferredRemesh();
         }
     }
 
@@ -566,246 +782,154 @@ public:
     }
 
 
-    // 检测两个三维坐标形成的体积是否与方块碰撞
-    bool isColliding(const glm::vec3& minBound, const glm::vec3& maxBound) {
-        // 步进大小
-        const float step = 0.3f;
-        const float eps = 0.0001f; // 阈值，避免检测非常小的范围
-
-        // 遍历检测碰撞范围内的点
-        if (maxBound.x - minBound.x > eps) {
-            for (float x = minBound.x; x < maxBound.x; x += step) {
-                for (float y = minBound.y; y < maxBound.y; y += step) {
-                    for (float z = minBound.z; z < maxBound.z; z += step) {
-                        int blockX = static_cast<int>(std::floor(x));
-                        int blockY = static_cast<int>(std::floor(y));
-                        int blockZ = static_cast<int>(std::floor(z));
-
-                        if (getBlock(blockX, blockY, blockZ) != BlockType::BLOCK_AIR) {
-                            return true; // 如果有非空气方块，发生碰撞
-                        }
-                    }
-                }
-            }
-        }
-
-        // maxBound.y 检查顶部边缘
-        if (maxBound.y - minBound.y > eps) {
-            for (float x = minBound.x; x <= maxBound.x; x += step) {
-                for (float z = minBound.z; z <= maxBound.z; z += step) {
-                    if (getBlock(static_cast<int>(std::floor(x)), static_cast<int>(std::floor(maxBound.y)), static_cast<int>(std::floor(z))) != BlockType::BLOCK_AIR) {
-                        return true;
-                    }
-                }
-            }
-        }
-
-        // maxBound.z 检查深度方向的边缘
-        if (maxBound.z - minBound.z > eps) {
-            for (float x = minBound.x; x <= maxBound.x; x += step) {
-                for (float y = minBound.y; y <= maxBound.y; y += step) {
-                    if (getBlock(static_cast<int>(std::floor(x)), static_cast<int>(std::floor(y)), static_cast<int>(std::floor(maxBound.z))) != BlockType::BLOCK_AIR) {
-                        return true;
-                    }
-                }
-            }
-        }
-
-        // maxBound.x 检查宽度方向的边缘
-        if (maxBound.x - minBound.x > eps) {
-            for (float y = minBound.y; y <= maxBound.y; y += step) {
-                for (float z = minBound.z; z <= maxBound.z; z += step) {
-                    if (getBlock(static_cast<int>(std::floor(maxBound.x)), static_cast<int>(std::floor(y)), static_cast<int>(std::floor(z))) != BlockType::BLOCK_AIR) {
-                        return true;
-                    }
-                }
-            }
-        }
-
-        return false; // 无碰撞
+    // 碰撞检测用: 实心方块 (水不阻挡移动), 或所在区块尚未加载完成 (防止玩家掉入或走进未生成的区块)
+    bool isCollisionBlock(int x, int y, int z) const {
+        return isSolidBlock(getBlock(x, y, z)) || !isColumnReady(x, z);
     }
 
-    // 检测两个三维坐标形成的体积是否与目标方块碰撞
-    bool isCollidingWith(const glm::vec3& minBound, const glm::vec3& maxBound, int targetBlockX, int targetBlockY, int targetBlockZ) {
-        const float step = 0.3f;
-        const float eps = 0.0001f; // 阈值，避免检测非常小的范围
-
-        // 检查目标方块是否在碰撞范围内
-        auto isTargetBlock = [&](int x, int y, int z) {
-            return x == targetBlockX && y == targetBlockY && z == targetBlockZ;
-        };
-
-        // 遍历检测碰撞范围内的点
-        if (maxBound.x - minBound.x > eps) {
-            for (float x = minBound.x; x < maxBound.x; x += step) {
-                for (float y = minBound.y; y < maxBound.y; y += step) {
-                    for (float z = minBound.z; z < maxBound.z; z += step) {
-                        int blockX = static_cast<int>(std::floor(x));
-                        int blockY = static_cast<int>(std::floor(y));
-                        int blockZ = static_cast<int>(std::floor(z));
-
-                        if (isTargetBlock(blockX, blockY, blockZ)) {
-                            return true; // 如果目标方块在范围内，发生碰撞
-                        }
-                    }
-                }
-            }
-        }
-
-        // maxBound.y 检查顶部边缘
-        if (maxBound.y - minBound.y > eps) {
-            for (float x = minBound.x; x <= maxBound.x; x += step) {
-                for (float z = minBound.z; z <= maxBound.z; z += step) {
-                    int blockX = static_cast<int>(std::floor(x));
-                    int blockY = static_cast<int>(std::floor(maxBound.y));
-                    int blockZ = static_cast<int>(std::floor(z));
-
-                    if (isTargetBlock(blockX, blockY, blockZ)) {
+    // 两个三维坐标形成的包围盒是否与方块重叠 (按包围盒实际覆盖的每个格子检测, 贴着表面不算)
+    bool isColliding(const glm::vec3& minBound, const glm::vec3& maxBound) const {
+        for (int x = firstOverlappedCell(minBound.x); x <= lastOverlappedCell(maxBound.x); ++x) {
+            for (int y = firstOverlappedCell(minBound.y); y <= lastOverlappedCell(maxBound.y); ++y) {
+                for (int z = firstOverlappedCell(minBound.z); z <= lastOverlappedCell(maxBound.z); ++z) {
+                    if (isCollisionBlock(x, y, z)) {
                         return true;
                     }
                 }
             }
         }
-
-        // maxBound.z 检查深度方向的边缘
-        if (maxBound.z - minBound.z > eps) {
-            for (float x = minBound.x; x <= maxBound.x; x += step) {
-                for (float y = minBound.y; y <= maxBound.y; y += step) {
-                    int blockX = static_cast<int>(std::floor(x));
-                    int blockY = static_cast<int>(std::floor(y));
-                    int blockZ = static_cast<int>(std::floor(maxBound.z));
-
-                    if (isTargetBlock(blockX, blockY, blockZ)) {
-                        return true;
-                    }
-                }
-            }
-        }
-
-        // maxBound.x 检查宽度方向的边缘
-        if (maxBound.x - minBound.x > eps) {
-            for (float y = minBound.y; y <= maxBound.y; y += step) {
-                for (float z = minBound.z; z <= maxBound.z; z += step) {
-                    int blockX = static_cast<int>(std::floor(maxBound.x));
-                    int blockY = static_cast<int>(std::floor(y));
-                    int blockZ = static_cast<int>(std::floor(z));
-
-                    if (isTargetBlock(blockX, blockY, blockZ)) {
-                        return true;
-                    }
-                }
-            }
-        }
-        return false; // 无碰撞
+        return false;
     }
 
-    void addBlockToGPU(int x, int y, int z) {
-        int blockIndex = x * worldHeight * worldDepth + y * worldDepth + z;
-
-        // 如果方块已存在于 GPU 中，则直接返回
-        if (blockVAOIndices[blockIndex] != -1) return;
-
-        // 获取当前方块的顶点数据
-        std::vector<float> blockVertices = getCubeVertices(x, y, z, getBlock(x, y, z));
+    // 两个三维坐标形成的包围盒是否与目标方块重叠
+    bool isCollidingWith(const glm::vec3& minBound, const glm::vec3& maxBound, int targetBlockX, int targetBlockY, int targetBlockZ) const {
+        return overlapsCell(minBound, maxBound, targetBlockX, targetBlockY, targetBlockZ);
+    }
 
-        int vaoIndex;
-        if (!airIndices.empty()) {
-            // 如果有可复用的 VAO 索引，从空气池中取出
-            vaoIndex = airIndices.back();
-            airIndices.pop_back();
+    // 沿 motion 移动包围盒, 停在碰到的第一个方块前 (见 Collision.hpp), 返回实际移动的距离和接触面的法线
+    SweepResult moveBox(const glm::vec3& minBound, const glm::vec3& maxBound, const glm::vec3& motion) const {
+        return sweepBox(minBound, maxBound, motion, [this](int x, int y, int z) {
+            return isCollisionBlock(x, y, z);
+        });
+    }
 
-            // 更新 VBO 数据
-            glBindBuffer(GL_ARRAY_BUFFER, VBO);
-            glBufferSubData(GL_ARRAY_BUFFER, vaoIndex * blockStride * sizeof(float), blockVertices.size() * sizeof(float), blockVertices.data());
-            glBindBuffer(GL_ARRAY_BUFFER, 0);
-        } else {
-            // 如果没有可复用的 VAO 索引，则追加到当前 VAO 末尾
-            vaoIndex = vaoSize++;
+    /*
+        推进一个模拟步: 执行到期的方块更新和水流, 处理寻路请求, 然后推进实体, 落地的下落方块放回方块网格
+        步内的编辑只在步末重建一次受影响的区块网格, 沙子整列下落时每步的开销也有上限
+    */
+    void tick(float dt) {
+        auto start = std::chrono::steady_clock::now();
+        deferRemesh = true;
+        blockTicks.tick([this](int x, int y, int z) {
+            updateGravityBlock(x, y, z);
+        });
+        if (blockTicks.currentTick % fluidStepInterval == 0) {
+            stepFluids();
+        }
+        paths.process([this](const Chunk& chunk) {
+            return grid.neighborsReached(chunk.cx, chunk.cz, CHUNK_MESHED); // 与 canEditBlock 相同的条件, 方块只会被主线程修改
+        });
+        entities.tick(dt, [this](int x, int y, int z) {
+            return isCollisionBlock(x, y, z); // 未加载的区块视为实心
+        });
+        landFallingBlocks();
+        deferRemesh = false;
+        flushDeferredRemesh();
+        worldTickMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
 
-            // 更新 VBO 数据
-            glBindBuffer(GL_ARRAY_BUFFER, VBO);
-            glBufferSubData(GL_ARRAY_BUFFER, vaoIndex * blockStride * sizeof(float), blockVertices.size() * sizeof(float), blockVertices.data());
-            glBindBuffer(GL_ARRAY_BUFFER, 0);
+    // 重建推迟的区块网格, 每个区块一次
+    void flushDeferredRemesh() {
+        std::sort(deferredRemesh.begin(), deferredRemesh.end(), [](const glm::ivec2& a, const glm::ivec2& b) {
+            return a.x != b.x ? a.x < b.x : a.y < b.y;
+        });
+        deferredRemesh.erase(std::unique(deferredRemesh.begin(), deferredRemesh.end()), deferredRemesh.end());
+        for (const glm::ivec2& chunk : deferredRemesh) {
+            remeshChunk(chunk.x, chunk.y);
         }
-
-        // 更新 VAO 索引映射
-        blockVAOIndices[blockIndex] = vaoIndex;
+        deferredRemesh.clear();
     }
 
-
-    void removeBlockFromGPU(int x, int y, int z) {
-        int blockIndex = x * worldHeight * worldDepth + y * worldDepth + z;
-        int vaoIndex = blockVAOIndices[blockIndex];
-
-        if (vaoIndex == -1) return; // 不在 GPU 中，无需移除
-
-        // 更新 VAO 数据为空气方块
-        std::vector<float> airVertices = getCubeVertices(x, y, z, BlockType::BLOCK_AIR);
-        int offset = vaoIndex * blockStride * sizeof(float);
-
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        glBufferSubData(GL_ARRAY_BUFFER, offset, airVertices.size() * sizeof(float), airVertices.data());
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-        // 回收 VAO 索引并更新映射
-        airIndices.push_back(vaoIndex);
-        blockVAOIndices[blockIndex] = -1;
+    // 推进一步水流, 变化的格子经 recordBlock 写入方块数据 (在存档锁内, 不会与自动保存的快照同时进行) 并重建网格
+    void stepFluids() {
+        fluids.step(fluidChanges, [this](const Chunk& chunk) {
+            return grid.neighborsReached(chunk.cx, chunk.cz, CHUNK_MESHED); // 与 canEditBlock 相同的条件
+        });
+        for (const FluidSimulation::Change& change : fluidChanges) {
+            recordBlock(change.x, change.y, change.z, change.type);
+            remeshAround(change.x, change.z);
+        }
+        fluidChanges.clear();
     }
 
-
-    // 方块是否未被遮挡
-    bool isBlockVisible(int x, int y, int z) {
+    // 受重力影响的方块下方为空气或水时, 变为下落的方块实体
+    void updateGravityBlock(int x, int y, int z) {
         BlockType type = getBlock(x, y, z);
-        // 空气直接不可见
-        if (type == BlockType::BLOCK_AIR) {
-            return false;
+        if (!isGravityBlock(type) || y == 0 || isSolidBlock(getBlock(x, y - 1, z)) || !isColumnReady(x, z)) return;
+        if (!canEditBlock(x, y, z)) {
+            blockTicks.schedule(x, y, z, gravityBlockDelay); // 周围区块还在构建网格, 稍后再试
+            return;
         }
+        setBlock(x, y, z, BlockType::BLOCK_AIR);
+        remeshAround(x, z);
+        float offset = (1.0f - fallingBlockSize) * 0.5f;
+        entities.spawn(glm::vec3(x + 0.5f, y + offset, z + 0.5f), glm::vec3(0.0f), fallingBlockSize, fallingBlockSize, type);
+    }
 
-        // 检查 6 个方向
-        // 如果越界、或者空气、或者是透明方块，就认为此方向是“敞开”的
-        // 只要有 1 个方向敞开，就可见
-        
-
-        for (auto &dir : dirs) {
-            int nx = x + dir[0];
-            int ny = y + dir[1];
-            int nz = z + dir[2];
-            // 越界算可见
-            if (nx < 0 || nx >= worldWidth  ||
-                ny < 0 || ny >= worldHeight ||
-                nz < 0 || nz >= worldDepth) {
-                return true;
-            }
-
-            BlockType neighborType = getBlock(nx, ny, nz);
-            if (isTransparent(neighborType)) {
-                return true;
+    /*
+        落地的下落方块放回所在的格子, 区块不可编辑时留到下一步
+        同一步内落下的多个方块可能落进同一格 (实体之间不做竖直碰撞), 此时依次向上堆叠; 世界顶部放不下时方块消失
+    */
+    void landFallingBlocks() {
+        for (int i = entities.size() - 1; i >= 0; --i) {
+            if (entities.block[i] == BlockType::BLOCK_AIR || !entities.onGround[i]) continue;
+            int x = (int)std::floor(entities.posX[i]), y = (int)std::round(entities.posY[i]), z = (int)std::floor(entities.posZ[i]);
+            if (grid.isInsideWorld(x, y, z) && !canEditBlock(x, y, z)) continue;
+            while (y < worldHeight && isSolidBlock(getBlock(x, y, z))) y++; // 水被落下的方块替换
+            if (grid.isInsideWorld(x, y, z)) {
+                setBlock(x, y, z, static_cast<BlockType>(entities.block[i]));
+                remeshAround(x, z);
             }
+            entities.remove(i);
         }
-
-        // 如果六面都被不透明方块包住，则不可见
-        return false;
     }
 
-    void updateVisibility(int x, int y, int z) {
-        // 越界检查
-        if (x < 0 || x >= worldWidth || y < 0 || y >= worldHeight || z < 0 || z >= worldDepth) {
-            return;
+    // 绘制下落中的方块: 每帧按插值位置重建一个小网格 (alpha 见 Player::update)
+    void renderEntities(const glm::mat4& view, const glm::mat4& projection, float alpha) {
+        entityVertices.clear();
+        for (int i = 0; i < entities.size(); ++i) {
+            if (entities.block[i] == BlockType::BLOCK_AIR) continue;
+            TextureType textureTypeTop = TEXTURE_AIR, textureTypeSide = TEXTURE_AIR, textureTypeBottom = TEXTURE_AIR;
+            getBlockTextures(entities.block[i], textureTypeTop, textureTypeSide, textureTypeBottom);
+            float size = entities.halfWidth[i] * 2.0f;
+            glm::vec3 origin = entities.getRenderPosition(i, alpha) - glm::vec3(entities.halfWidth[i], 0.0f, entities.halfWidth[i]);
+            glm::ivec3 cell(glm::floor(origin + entities.halfWidth[i]));
+            float light = float(lighting.lightAt(cell.x, cell.y, cell.z)); // 整个方块取中心所在格子的光照
+            for (int face = 0; face < 6; ++face) {
+                float texture = float(face == 2 ? textureTypeTop : face == 3 ? textureTypeBottom : textureTypeSide);
+                for (const auto& v : cubeFaceVertices[face]) {
+                    entityVertices.insert(entityVertices.end(), { origin.x + v[0] * size, origin.y + v[1] * size, origin.z + v[2] * size, v[3], v[4], texture, light });
+                }
+            }
         }
-        // 更新当前方块的可见性
-        bool visible = isBlockVisible(x, y, z);
+        if (entityVertices.empty()) return;
 
-        if (visible && !visibleBlocks[x][y][z]) {
-            // 方块从不可见变为可见，加入 GPU
-            addBlockToGPU(x, y, z);
-            visibleBlocks[x][y][z] = true;
-        } else if (!visible && visibleBlocks[x][y][z]) {
-            // 方块从可见变为不可见，从 GPU 移除
-            removeBlockFromGPU(x, y, z);
-            visibleBlocks[x][y][z] = false;
+        if (entityMesh.VAO == 0) {
+            createMeshBuffers(entityMesh);
         }
+        glBindBuffer(GL_ARRAY_BUFFER, entityMesh.VBO);
+        glBufferData(GL_ARRAY_BUFFER, entityVertices.size() * sizeof(float), entityVertices.data(), GL_STREAM_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        entityMesh.vertexCount = entityVertices.size() / 7;
+
+        world_shader.use();
+        world_shader.setUniformMatrix4fv("view", glm::value_ptr(view));
+        world_shader.setUniformMatrix4fv("projection", glm::value_ptr(projection));
+        glBindVertexArray(entityMesh.VAO);
+        glDrawArrays(GL_TRIANGLES, 0, entityMesh.vertexCount);
+        glBindVertexArray(0);
     }
-    
+
     void renderWireframe(const glm::mat4& view, const glm::mat4& projection, const glm::vec3& blockPos) {
         wireframe.render(view, projection, blockPos);
     }
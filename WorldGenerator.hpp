@@ -0,0 +1,410 @@
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <FastNoiseLite.h>
+#include "Block.hpp"
+#include "Chunk.hpp"
+#include "Random.hpp"
+#include "NoiseGrid.hpp"
+#include "Structure.hpp"
+
+/*
+    地形生成器 (不依赖 OpenGL, 可在任意线程调用)
+    所有随机性都是 (worldSeed, 坐标, 随机流) 的哈希, 与区块的生成顺序和线程数无关,
+    同一种子生成的世界逐字节相同
+*/
+class WorldGenerator {
+public:
+    static const uint32_t version = 1; // 生成结果发生变化时递增, 使磁盘上的旧区块缓存失效
+    const int maxTreeHeight = 7; // 树木最大高度
+    const int treeSpacing = 5;   // 树木间隔 (树冠之外的空隙)
+    const int treeRadius = 2;    // 树冠半径
+    const int treeCellSize = 12; // 树木网格单元边长, 每个单元至多一棵树
+    const int treeJitter = treeCellSize - treeSpacing - treeRadius; // 单元内树干可出现的窗口边长
+    const float treeChance = 0.12f; // 每个单元长树的概率
+    int worldSeed;
+    const float basinThreshold = 0.2f; // 生物群系噪声高于此值为盆地
+    int worldWidth, worldHeight, worldDepth;
+    const int smoothMaxDelta = 2;   // 平滑后相邻高度的最大差值
+    const int smoothIterations = 4; // 平滑扫描次数
+    PerlinNoise2D terrainNoise; // 地形高度噪声
+    PerlinNoise2D biomeNoise;   // 盆地/平原噪声
+    PerlinNoise2D dirtNoise;    // 泥土层厚度噪声
+    FastNoiseLite densityNoise; // 三维密度噪声 (悬空、凹洞)
+    std::vector<StructureStamp> treeStamps; // 预编译的树木模板, 下标为 树高 - 5
+
+    // 三维密度: density = (地表高度 - y) + densityAmplitude * 噪声, 大于 0 为实心 (振幅为 0 时退化为纯高度图)
+    // 噪声只在 densityCellX x densityCellY x densityCellZ 的粗网格格点上求值, 格内三线性插值
+    float densityAmplitude = 8.0f;
+    const int densityCellX = 4, densityCellY = 8, densityCellZ = 4;
+
+    // 噪声种子由地图种子派生
+    WorldGenerator(int seed, int w, int h, int d)
+        : worldSeed(seed), worldWidth(w), worldHeight(h), worldDepth(d),
+          terrainNoise((int)Random::at(seed, Random::STREAM_NOISE_SEED, 0), 0.03f),
+          biomeNoise((int)Random::at(seed, Random::STREAM_NOISE_SEED, 1), 0.01f),
+          dirtNoise((int)Random::at(seed, Random::STREAM_NOISE_SEED, 2), 0.15f) {
+        densityNoise.SetNoiseType(FastNoiseLite::NoiseType_Perlin);
+        densityNoise.SetFrequency(0.12f);
+        densityNoise.SetSeed((int)Random::at(seed, Random::STREAM_NOISE_SEED, 3));
+
+        for (int treeHeight = 5; treeHeight <= maxTreeHeight; ++treeHeight) {
+            treeStamps.push_back(buildTreeStamp(treeHeight));
+        }
+    }
+
+    // 原始地形高度 (平滑之前), 由地形噪声和生物群系噪声决定
+    int rawHeight(float terrainValue, float biomeValue) const {
+        float normalizedTerrain = (terrainValue + 1.0f) / 2.0f;
+        bool isBasin = biomeValue > basinThreshold;
+
+        int terrainHeight = isBasin
+            ? (int)(normalizedTerrain * (worldHeight / 4 - 1)) + 1 // [1, worldHeight/4]
+            : (int)(normalizedTerrain * (worldHeight - 1)) + 1;    // [1, worldHeight]
+        return std::max(terrainHeight, 1);
+    }
+
+    /*
+        区块 (cx, cz) 内各列平滑后的地表高度和生物群系噪声, 写入 heights 和 biomes (CHUNK_SIZE * CHUNK_SIZE, x 为外层)
+        平滑是局部操作, 迭代 n 次只依赖 n 格以内的原始高度, 因此在区块外扩 n 格计算即可与整图平滑结果一致
+    */
+    void terrainHeights(int cx, int cz, int* heights, float* biomes) const {
+        const int halo = smoothIterations;
+
+        int x0 = cx * CHUNK_SIZE, z0 = cz * CHUNK_SIZE;
+        int rx0 = std::max(0, x0 - halo), rx1 = std::min(worldWidth, x0 + CHUNK_SIZE + halo);
+        int rz0 = std::max(0, z0 - halo), rz1 = std::min(worldDepth, z0 + CHUNK_SIZE + halo);
+
+        // 批量计算整块区域的噪声, 每列只求值一次, 后续步骤直接读数组
+        const int regionWidth = rx1 - rx0, regionDepth = rz1 - rz0;
+        std::vector<float> terrainValues(regionWidth * regionDepth);
+        std::vector<float> biomeValues(regionWidth * regionDepth);
+        terrainNoise.fill(rx0, rz0, regionWidth, regionDepth, terrainValues.data());
+        biomeNoise.fill(rx0, rz0, regionWidth, regionDepth, biomeValues.data());
+
+        // 原始地形高度 (含外扩区域, 扁平存储, x 为外层)
+        std::vector<int> heightMap(regionWidth * regionDepth);
+        for (int i = 0; i < regionWidth * regionDepth; ++i) {
+            heightMap[i] = rawHeight(terrainValues[i], biomeValues[i]);
+        }
+
+        // 平滑地形高度 (世界边缘和外扩区域边缘不调整), 两个缓冲区交替读写
+        // 外扩区域边缘的误差每次扫描向内传播一格, 因此第 iter 次扫描在外扩一侧可以少算 iter 格
+        std::vector<int> smoothed = heightMap;
+        for (int iter = 0; iter < smoothIterations; ++iter) {
+            int xBegin = rx0 > 0 ? rx0 + 1 + iter : 1;
+            int xEnd = rx1 < worldWidth ? rx1 - 1 - iter : worldWidth - 1;
+            int zBegin = rz0 > 0 ? rz0 + 1 + iter : 1;
+            int zEnd = rz1 < worldDepth ? rz1 - 1 - iter : worldDepth - 1;
+            smoothPass(heightMap.data(), smoothed.data(), regionDepth,
+                xBegin - rx0, xEnd - rx0, zBegin - rz0, zEnd - rz0, smoothMaxDelta);
+            heightMap.swap(smoothed);
+        }
+
+        const int chunkWidth = std::min(worldWidth, x0 + CHUNK_SIZE) - x0;
+        const int chunkDepth = std::min(worldDepth, z0 + CHUNK_SIZE) - z0;
+        for (int lx = 0; lx < chunkWidth; ++lx) {
+            for (int lz = 0; lz < chunkDepth; ++lz) {
+                heights[lx * CHUNK_SIZE + lz] = heightMap[(lx + x0 - rx0) * regionDepth + (lz + z0 - rz0)];
+                biomes[lx * CHUNK_SIZE + lz] = biomeValues[(lx + x0 - rx0) * regionDepth + (lz + z0 - rz0)];
+            }
+        }
+    }
+
+    // 生成区块地形 (工作线程)
+    void generateChunk(Chunk& chunk) const {
+        int x0 = chunk.cx * CHUNK_SIZE, z0 = chunk.cz * CHUNK_SIZE;
+
+        // 第一、二步：平滑后的地表高度和生物群系噪声
+        int heightMap[CHUNK_SIZE * CHUNK_SIZE] = {};
+        float dirtValues[CHUNK_SIZE * CHUNK_SIZE];
+        terrainHeights(chunk.cx, chunk.cz, heightMap, chunk.biomeMap.data());
+        dirtNoise.fill(x0, z0, CHUNK_SIZE, CHUNK_SIZE, dirtValues);
+
+        // 第三步：按三维密度确定实心方块
+        const int chunkWidth = std::min(worldWidth, x0 + CHUNK_SIZE) - x0;
+        const int chunkDepth = std::min(worldDepth, z0 + CHUNK_SIZE) - z0;
+        std::vector<uint8_t> solid(CHUNK_SIZE * CHUNK_SIZE * worldHeight, 0);
+        fillDensity(heightMap, CHUNK_SIZE, 0, 0, chunk.cx, chunk.cz, chunkWidth, chunkDepth, solid.data());
+
+        // 第四步：生成方块 (直接写入本区块), 从上往下数离空气的深度: 表层为草, 其下 dirtDepth 格为泥土, 再往下为石头
+        for (int lx = 0; lx < chunkWidth; ++lx) {
+            for (int lz = 0; lz < chunkDepth; ++lz) {
+                int terrainHeight = heightMap[lx * CHUNK_SIZE + lz];
+                float dirtValue = dirtValues[lx * CHUNK_SIZE + lz];
+                int dirtDepth = (int)((dirtValue + 1.0f) / 2.0f * terrainHeight / 2) + smoothMaxDelta; // [smoothMaxDelta, terrainHeight/2 + smoothMaxDelta]
+
+                int surfaceHeight = 0;  // 最高实心方块之上的高度
+                int depthBelowAir = 0;  // 距离上方最近空气的深度
+                for (int y = worldHeight - 1; y >= 0; --y) {
+                    uint8_t& block = chunk.blocks[ChunkGrid::blockIndex(lx, y, lz)];
+                    if (!solid[ChunkGrid::blockIndex(lx, y, lz)]) {
+                        block = BlockType::BLOCK_AIR;
+                        depthBelowAir = 0;
+                        continue;
+                    }
+                    if (surfaceHeight == 0) surfaceHeight = y + 1;
+                    if (depthBelowAir == 0) {
+                        block = BlockType::GRASS_BLOCK;
+                    } else if (depthBelowAir < dirtDepth) {
+                        block = BlockType::DIRT_BLOCK;
+                    } else {
+                        block = BlockType::STONE_BLOCK;
+                    }
+                    depthBelowAir++;
+                }
+                chunk.heightMap[lx * CHUNK_SIZE + lz] = surfaceHeight;
+            }
+        }
+    }
+
+    /*
+        计算区块内每个方块是否实心, 结果写入 solid (下标同 ChunkGrid::blockIndex)
+        heightMap 为平滑后的地表高度 (含外扩区域, 每行 heightDepth 个), (offsetX, offsetZ) 为区块原点在其中的位置
+        插值结果不会超出格点值的范围 (|噪声| <= 1), 所以一个格子内若 y 都低于 最低地表 - 振幅 则整格实心,
+        都不低于 最高地表 + 振幅 则整格为空气, 这两种格子不求噪声; 只有跨越地表的格子才在格点上采样
+        返回噪声求值次数
+    */
+    int fillDensity(const int* heightMap, int heightDepth, int offsetX, int offsetZ, int cx, int cz,
+                    int chunkWidth, int chunkDepth, uint8_t* solid) const {
+        const int cellsX = CHUNK_SIZE / densityCellX;
+        const int cellsY = (worldHeight + densityCellY - 1) / densityCellY;
+        const int cellsZ = CHUNK_SIZE / densityCellZ;
+        const int pointsY = cellsY + 1, pointsZ = cellsZ + 1;
+
+        // 格点噪声按需求值并缓存, 相邻格子共享格点
+        std::vector<float> lattice((cellsX + 1) * pointsY * pointsZ, 0.0f);
+        std::vector<uint8_t> sampled(lattice.size(), 0);
+        int evaluations = 0;
+        auto latticeValue = [&](int i, int j, int k) {
+            int index = (i * pointsY + j) * pointsZ + k;
+            if (!sampled[index]) {
+                lattice[index] = densityNoise.GetNoise((float)(cx * CHUNK_SIZE + i * densityCellX), (float)(j * densityCellY), (float)(cz * CHUNK_SIZE + k * densityCellZ));
+                sampled[index] = 1;
+                evaluations++;
+            }
+            return lattice[index];
+        };
+
+        for (int i = 0; i < cellsX; ++i) {
+            for (int k = 0; k < cellsZ; ++k) {
+                const int lx0 = i * densityCellX, lz0 = k * densityCellZ;
+                const int lx1 = std::min(lx0 + densityCellX, chunkWidth), lz1 = std::min(lz0 + densityCellZ, chunkDepth);
+                if (lx0 >= lx1 || lz0 >= lz1) continue; // 世界之外
+
+                int minHeight = worldHeight, maxHeight = 0;
+                for (int lx = lx0; lx < lx1; ++lx) {
+                    for (int lz = lz0; lz < lz1; ++lz) {
+                        int h = heightMap[(lx + offsetX) * heightDepth + (lz + offsetZ)];
+                        minHeight = std::min(minHeight, h);
+                        maxHeight = std::max(maxHeight, h);
+                    }
+                }
+
+                for (int j = 0; j < cellsY; ++j) {
+                    const int y0 = j * densityCellY, y1 = std::min(y0 + densityCellY, worldHeight);
+                    if (y1 - 1 < minHeight - densityAmplitude || y0 >= maxHeight + densityAmplitude) {
+                        // 整格实心或整格空气, 直接由高度决定
+                        uint8_t value = y0 < minHeight ? 1 : 0;
+                        for (int y = y0; y < y1; ++y) {
+                            for (int lz = lz0; lz < lz1; ++lz) {
+                                for (int lx = lx0; lx < lx1; ++lx) {
+                                    solid[ChunkGrid::blockIndex(lx, y, lz)] = value;
+                                }
+                            }
+                        }
+                        continue;
+                    }
+
+                    const float n000 = latticeValue(i, j, k), n100 = latticeValue(i + 1, j, k);
+                    const float n001 = latticeValue(i, j, k + 1), n101 = latticeValue(i + 1, j, k + 1);
+                    const float n010 = latticeValue(i, j + 1, k), n110 = latticeValue(i + 1, j + 1, k);
+                    const float n011 = latticeValue(i, j + 1, k + 1), n111 = latticeValue(i + 1, j + 1, k + 1);
+                    for (int lx = lx0; lx < lx1; ++lx) {
+                        const float tx = (float)(lx - lx0) / densityCellX;
+                        for (int lz = lz0; lz < lz1; ++lz) {
+                            const float tz = (float)(lz - lz0) / densityCellZ;
+                            const float bottom = (n000 + (n100 - n000) * tx) * (1 - tz) + (n001 + (n101 - n001) * tx) * tz;
+                            const float top = (n010 + (n110 - n010) * tx) * (1 - tz) + (n011 + (n111 - n011) * tx) * tz;
+                            const int h = heightMap[(lx + offsetX) * heightDepth + (lz + offsetZ)];
+                            for (int y = y0; y < y1; ++y) {
+                                const float ty = (float)(y - y0) / densityCellY;
+                                const float noise = bottom + (top - bottom) * ty;
+                                // 最底层始终实心, 避免挖穿世界
+                                solid[ChunkGrid::blockIndex(lx, y, lz)] = y == 0 || (h - y) + densityAmplitude * noise > 0.0f;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        return evaluations;
+    }
+
+    /*
+        一次平滑扫描: [xBegin, xEnd) x [zBegin, zEnd) 内的点若比某个邻居低 maxDelta 以上, 就提升到两者中间
+        多个邻居满足条件时以 (dx, dz) 遍历顺序中最后一个为准, 所以这里按同样的顺序做条件选择 (而不是取最大值),
+        结果与逐个邻居判断赋值的写法完全相同; 循环体没有分支, 编译器可以向量化
+        src 和 dst 是同尺寸的扁平数组 (x 为外层, 每行 depth 个), 范围外的点不写入
+    */
+    static void smoothPass(const int* src, int* dst, int depth, int xBegin, int xEnd, int zBegin, int zEnd, int maxDelta) {
+        for (int x = xBegin; x < xEnd; ++x) {
+            const int* prev = src + (x - 1) * depth;
+            const int* row = src + x * depth;
+            const int* next = src + (x + 1) * depth;
+            int* out = dst + x * depth;
+            for (int z = zBegin; z < zEnd; ++z) {
+                const int current = row[z];
+                int result = current;
+                result = current < prev[z - 1] - maxDelta ? current + (prev[z - 1] - current) / 2 : result;
+                result = current < prev[z]     - maxDelta ? current + (prev[z]     - current) / 2 : result;
+                result = current < prev[z + 1] - maxDelta ? current + (prev[z + 1] - current) / 2 : result;
+                result = current < row[z - 1]  - maxDelta ? current + (row[z - 1]  - current) / 2 : result;
+                result = current < row[z + 1]  - maxDelta ? current + (row[z + 1]  - current) / 2 : result;
+                result = current < next[z - 1] - maxDelta ? current + (next[z - 1] - current) / 2 : result;
+                result = current < next[z]     - maxDelta ? current + (next[z]     - current) / 2 : result;
+                result = current < next[z + 1] - maxDelta ? current + (next[z + 1] - current) / 2 : result;
+                out[z] = result;
+            }
+        }
+    }
+
+    // 一棵树的位置和形状
+    struct TreePlacement {
+        int x, z;          // 树干位置
+        int baseHeight;    // 树底高度
+        int treeHeight;    // 树的总高度 5/6/7
+    };
+
+    /*
+        树木网格单元 (cellX, cellZ) 中的树干位置, 该单元不长树时返回 false
+        每个单元至多一棵树, 树干只落在单元中间 treeJitter x treeJitter 的窗口内,
+        相邻单元的树干至少相距 treeCellSize - treeJitter + 1 = treeSpacing + treeRadius + 1,
+        树冠之间的间隔由构造保证, 不需要与其它树比较, 也不需要扫描已写入的方块
+        只依赖地图种子和单元坐标, O(1)
+    */
+    bool treeInCell(int cellX, int cellZ, int& x, int& z) const {
+        uint32_t roll = Random::at(worldSeed, Random::STREAM_TREE, cellX, 0, cellZ);
+        if ((roll >> 8) * (1.0f / 16777216.0f) >= treeChance) return false;
+        uint32_t jitter = Random::at(worldSeed, Random::STREAM_TREE, cellX, 1, cellZ);
+        const int margin = (treeCellSize - treeJitter) / 2;
+        x = cellX * treeCellSize + margin + (int)(jitter % treeJitter);
+        z = cellZ * treeCellSize + margin + (int)((jitter >> 16) % treeJitter);
+        return true;
+    }
+
+    // 网格单元 (cellX, cellZ) 中的树, 只读取树干所在区块的高度图和生物群系缓存
+    bool treeAt(const ChunkGrid& grid, int cellX, int cellZ, TreePlacement& tree) const {
+        int x, z;
+        if (!treeInCell(cellX, cellZ, x, z)) return false;
+        if (x >= worldWidth || z >= worldDepth) return false;
+        const Chunk& owner = *grid.getChunk(x / CHUNK_SIZE, z / CHUNK_SIZE);
+        int column = (x % CHUNK_SIZE) * CHUNK_SIZE + z % CHUNK_SIZE;
+
+        bool isBasin = owner.biomeMap[column] > basinThreshold;
+        int terrainHeight = owner.heightMap[column];
+        // 盆地不长树; 树的顶部超出世界高度也不放置
+        if (isBasin || terrainHeight + maxTreeHeight >= worldHeight) return false;
+
+        int treeHeight = 5 + Random::at(worldSeed, Random::STREAM_TREE_HEIGHT, x, 0, z) % 3; // 树高度随机在 5 到 7 之间
+        tree = { x, z, terrainHeight, treeHeight };
+        return true;
+    }
+
+    /*
+        装饰区块 (装饰阶段): 粘贴所有伸入本区块的树木模板中落在本区块的部分
+        树冠跨区块时, 各区块只写自己的那一部分, 不写入相邻区块; 树冠互不重叠 (见 treeInCell),
+        因此各区块的装饰可以并行且结果与顺序无关
+        需要 3x3 区块都已生成 (读取相邻区块的高度图), 返回粘贴的模板数
+    */
+    int decorateChunk(const ChunkGrid& grid, Chunk& chunk) const {
+        // 树干在区块外 treeRadius 格以内的树, 树冠也会伸入本区块
+        int x0 = chunk.cx * CHUNK_SIZE, z0 = chunk.cz * CHUNK_SIZE;
+        int cellX0 = std::max(0, x0 - treeRadius) / treeCellSize, cellX1 = (x0 + CHUNK_SIZE - 1 + treeRadius) / treeCellSize;
+        int cellZ0 = std::max(0, z0 - treeRadius) / treeCellSize, cellZ1 = (z0 + CHUNK_SIZE - 1 + treeRadius) / treeCellSize;
+        int stamps = 0;
+        for (int cellX = cellX0; cellX <= cellX1; ++cellX) {
+            for (int cellZ = cellZ0; cellZ <= cellZ1; ++cellZ) {
+                TreePlacement tree;
+                if (!treeAt(grid, cellX, cellZ, tree)) continue;
+                if (treeStamps[tree.treeHeight - 5].paste(grid, chunk, tree.x, tree.baseHeight, tree.z) > 0) {
+                    stamps++;
+                }
+            }
+        }
+        return stamps;
+    }
+
+    // 编译高度为 treeHeight 的树木模板, 原点为树干底部
+    static StructureStamp buildTreeStamp(int treeHeight) {
+        StructureStamp stamp;
+        const int x = 0, z = 0, baseHeight = 0;
+        for (int y = baseHeight; y < baseHeight + treeHeight - 1; ++y) {
+            stamp.set(x, y, z, BlockType::OAK_LOG); // 树干用类型 2 表示
+        }
+
+        if (treeHeight >=6){
+            for (int y = baseHeight + treeHeight -1; y > baseHeight && y> baseHeight + treeHeight - 5; y--){
+                // 顶层树叶 
+                if (y == baseHeight + treeHeight - 1){
+                    for (int dx = x - 1; dx <= x + 1; dx++){
+                        for (int dz = z - 1; dz <= z + 1; dz++){
+                            if (dx == x || dz == z){
+                                stamp.set(dx, y, dz, BlockType::OAK_LEAVES);
+                            }
+                        }
+                    }
+                }
+                // 2层
+                else if (y == baseHeight + treeHeight - 2){
+                    for (int dx = x - 1; dx <= x + 1; dx++){
+                        for(int dz= z - 1; dz <= z + 1; dz++){
+                            // 躲避树干
+                            if (dx != x || dz != z){
+                                stamp.set(dx, y, dz, BlockType::OAK_LEAVES);
+                            }
+                        }
+                    }
+                }
+                // 34层
+                else if (y < baseHeight + treeHeight - 2){
+                    for (int dx = x - 2; dx <= x + 2; dx++){
+                        for(int dz= z - 2; dz <= z + 2; dz++){
+                            if (dx != x || dz != z){
+                                stamp.set(dx, y, dz, BlockType::OAK_LEAVES);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        else if (treeHeight == 5) { 
+            for (int y = baseHeight + treeHeight -1; y > baseHeight && y> baseHeight + treeHeight - 4; y--){
+                // 顶层树叶 
+                if (y == baseHeight + treeHeight - 1){
+                    for (int dx = x - 1; dx <= x + 1; dx++){
+                        for (int dz = z - 1; dz <= z + 1; dz++){
+                            if (dx == x || dz == z){
+                                stamp.set(dx, y, dz, BlockType::OAK_LEAVES);
+                            }
+                        }
+                    }
+                }
+                // 23层
+                else if (y <= baseHeight + treeHeight - 2){
+                    for (int dx = x - 2; dx <= x + 2; dx++){
+                        for(int dz= z - 2; dz <= z + 2; dz++){
+                            // 躲避树干
+                            if (dx != x || dz != z){
+                                stamp.set(dx, y, dz, BlockType::OAK_LEAVES);
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        stamp.compile();
+        return stamp;
+    }
+};
@@ -0,0 +1,309 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <cstdint>
+#include "Chunk.hpp"
+#include "RegionFile.hpp"
+
+/*
+    玩家存档: 保存被玩家修改过的区块, 与只含生成结果的 ChunkCache 分开存放在 saves/<种子>/ 下
+    每次修改方块都把所在区块标记为脏, 并向预写日志 (edits.journal) 追加一条记录;
+    后台线程每 journalFlushMs 毫秒把新记录追加到日志并落盘 (fsync), 每隔 autosaveSeconds 秒在编辑锁内复制脏区块的快照 (只复制几 KB),
+    释放锁后再把快照写入区域文件 (同样落盘), 写完后替换日志; 掉电时最多丢失最后 journalFlushMs 毫秒内的修改
+    程序崩溃后重新启动时读取日志, 区块载入后重放其中的修改; 主线程只在内存中追加记录, 不等待磁盘
+*/
+class WorldSave {
+public:
+    static const uint32_t journalMagic = 0x4C4E524A; // "JRNL"
+
+    // 一次方块修改 (12 字节)
+    struct EditRecord {
+        int32_t x, z;
+        uint16_t y;
+        uint8_t block;
+        uint8_t reserved;
+    };
+
+    struct JournalHeader {
+        uint32_t magic;
+        int32_t seed;
+    };
+
+    int autosaveSeconds = 30;     // 自动保存间隔
+    int journalFlushMs = 200;     // 日志写入磁盘的间隔
+
+    // 统计 (供调试界面显示)
+    std::atomic<long long> chunksSaved{0};   // 累计保存的区块数
+    std::atomic<int> lastSaveChunks{0};      // 上次自动保存的区块数
+    std::atomic<float> lastSaveMs{0.0f};     // 上次自动保存的耗时 (含快照和写入)
+    std::atomic<int> replayedEdits{0};       // 从日志重放的修改数
+
+    WorldSave(const std::string& root, int seed, ChunkGrid& grid)
+        : directory(root + "/" + std::to_string(seed)), seed(seed), grid(grid),
+          storage(directory, makeHeader(seed, grid.worldHeight)), dirty(grid.chunks.size(), 0) {
+        journalPath = directory + "/edits.journal";
+        readJournal();
+        rewriteJournal(replayRecords()); // 只保留能识别的记录, 丢弃崩溃时写了一半的尾部
+    }
+
+    ~WorldSave() {
+        stop();
+    }
+
+    const std::string& getDirectory() const {
+        return directory;
+    }
+
+    // 启动后台保存线程
+    void start() {
+        if (worker.joinable()) return;
+        stopping = false;
+        openJournal();
+        worker = std::thread(&WorldSave::workerLoop, this);
+    }
+
+    // 停止后台线程, 并保存所有脏区块
+    void stop() {
+        if (!worker.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeup.notify_all();
+        worker.join();
+        autosave();
+        journal.close();
+    }
+
+    // 修改方块 (主线程): 标记区块为脏并在内存中追加日志记录
+    void setBlock(int x, int y, int z, BlockType type) {
+        if (!grid.isInsideWorld(x, y, z)) return;
+        std::lock_guard<std::mutex> lock(mutex);
+        grid.setBlock(x, y, z, type);
+        markDirty((x / CHUNK_SIZE) * grid.chunksZ + z / CHUNK_SIZE);
+        pendingRecords.push_back({ x, z, (uint16_t)y, (uint8_t)type, 0 });
+    }
+
+    // 从存档载入被修改过的区块并重放日志 (工作线程); 区块从未保存过时返回 false
+    bool load(Chunk& chunk) {
+        if (!storage.load(chunk)) return false;
+        applyJournal(chunk);
+        return true;
+    }
+
+    // 把日志中属于该区块的修改应用到刚生成或载入的区块上 (工作线程)
+    void applyJournal(Chunk& chunk) {
+        int index = chunk.cx * grid.chunksZ + chunk.cz;
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = replay.find(index);
+        if (found == replay.end()) return;
+        for (const EditRecord& record : found->second) {
+            chunk.blocks[ChunkGrid::blockIndex(record.x % CHUNK_SIZE, record.y, record.z % CHUNK_SIZE)] = record.block;
+        }
+        replayedEdits += (int)found->second.size();
+        replay.erase(found);
+        markDirty(index); // 下次自动保存后这些修改才能从日志中删除
+    }
+
+    // 区块是否有尚未保存的修改 (自动保存线程会读取这些区块)
+    bool isDirty(int index) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return dirty[index] != 0;
+    }
+
+    int dirtyChunkCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return (int)dirtyList.size();
+    }
+
+    // 日志中尚未被保存覆盖的记录数
+    int journalRecordCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return journalRecords + (int)pendingRecords.size();
+    }
+
+    // 立即保存所有脏区块并截断日志 (在后台线程中调用; 也可在后台线程停止后直接调用)
+    void autosave() {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<EditRecord> records;
+        std::vector<Chunk> snapshots;
+        {
+            // 快照: 日志记录和区块内容在同一把锁内取出, 保证快照恰好包含这些记录
+            std::lock_guard<std::mutex> lock(mutex);
+            records.swap(pendingRecords);
+            snapshots = std::vector<Chunk>(dirtyList.size());
+            for (size_t i = 0; i < dirtyList.size(); ++i) {
+                const Chunk& chunk = grid.chunks[dirtyList[i]];
+                snapshots[i].cx = chunk.cx;
+                snapshots[i].cz = chunk.cz;
+                snapshots[i].blocks = chunk.blocks;
+                snapshots[i].heightMap = chunk.heightMap;
+                snapshots[i].biomeMap = chunk.biomeMap;
+                dirty[dirtyList[i]] = 0;
+            }
+            dirtyList.clear();
+            journalRecords += (int)records.size();
+        }
+
+        // 先把记录写入日志, 写区域文件的过程中崩溃时仍可重放
+        appendJournal(records);
+
+        bool saved = true;
+        for (const Chunk& snapshot : snapshots) {
+            saved = storage.save(snapshot) && saved;
+        }
+        if (!saved) {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const Chunk& snapshot : snapshots) {
+                markDirty(snapshot.cx * grid.chunksZ + snapshot.cz);
+            }
+            std::cout << "[INFO] Autosave failed, keeping journal: " << journalPath << std::endl;
+            return;
+        }
+
+        // 快照已写入, 日志中只需保留尚未应用到区块上的重放记录; 之后的新记录仍在 pendingRecords 中
+        std::vector<EditRecord> remaining;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            remaining = replayRecords();
+            journalRecords = (int)remaining.size();
+        }
+        journal.close();
+        rewriteJournal(remaining);
+        openJournal();
+
+        chunksSaved += (long long)snapshots.size();
+        lastSaveChunks = (int)snapshots.size();
+        lastSaveMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    std::string directory;
+    std::string journalPath;
+    int seed;
+    ChunkGrid& grid;
+    RegionStorage storage;
+
+    std::mutex mutex;                              // 保护以下数据和玩家修改的方块
+    std::vector<char> dirty;                       // 每个区块是否有未保存的修改
+    std::vector<int> dirtyList;                    // 脏区块的索引
+    std::vector<EditRecord> pendingRecords;        // 尚未写入日志文件的记录
+    int journalRecords = 0;                        // 已写入日志文件的记录数
+    std::unordered_map<int, std::vector<EditRecord>> replay; // 启动时从日志读出, 等待区块载入后重放
+
+    IOFile journal;                                // 只在后台线程 (或其停止后) 使用
+    uint64_t journalBytes = 0;                     // 日志文件的长度 (下一条记录的写入位置)
+    std::thread worker;
+    std::condition_variable wakeup;
+    bool stopping = false;
+
+    // 存档中的区块是完整数据, 不依赖生成器版本
+    static RegionFile::FileHeader makeHeader(int seed, int worldHeight) {
+        RegionFile::FileHeader header = {};
+        header.magic = RegionFile::fileMagic;
+        header.formatVersion = RegionFile::formatVersion;
+        header.seed = seed;
+        header.worldHeight = worldHeight;
+        return header;
+    }
+
+    void markDirty(int index) {
+        if (!dirty[index]) {
+            dirty[index] = 1;
+            dirtyList.push_back(index);
+        }
+    }
+
+    void readJournal() {
+        std::ifstream file(journalPath, std::ios::binary);
+        JournalHeader header;
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != journalMagic || header.seed != seed) {
+            return;
+        }
+        EditRecord record;
+        while (file.read(reinterpret_cast<char*>(&record), sizeof(record))) {
+            if (!grid.isInsideWorld(record.x, record.y, record.z) || record.block >= BLOCK_TYPE_COUNT) continue;
+            replay[(record.x / CHUNK_SIZE) * grid.chunksZ + record.z / CHUNK_SIZE].push_back(record);
+            journalRecords++;
+        }
+        if (journalRecords > 0) {
+            std::cout << "[INFO] Journal: " << journalRecords << " edits to replay from " << journalPath << std::endl;
+        }
+    }
+
+    std::vector<EditRecord> replayRecords() const {
+        std::vector<EditRecord> records;
+        for (const auto& entry : replay) {
+            records.insert(records.end(), entry.second.begin(), entry.second.end());
+        }
+        return records;
+    }
+
+    // 用 records 替换日志内容: 先写临时文件并落盘, 再改名并落盘所在目录, 中途崩溃或掉电时旧日志仍然完整
+    void rewriteJournal(const std::vector<EditRecord>& records) {
+        std::string tempPath = journalPath + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            JournalHeader header = { journalMagic, seed };
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(EditRecord));
+            if (!file.flush()) return;
+        }
+        IOFile temp;
+        if (!temp.open(tempPath, false) || !temp.sync()) return;
+        temp.close(); // Windows 上打开的文件不能被改名替换
+        if (!replaceFileDurably(tempPath, journalPath)) {
+            std::cout << "[INFO] Failed to replace journal: " << journalPath << std::endl;
+        }
+    }
+
+    // 打开日志以追加记录
+    void openJournal() {
+        std::error_code error;
+        journalBytes = std::filesystem::file_size(journalPath, error);
+        if (error || !journal.open(journalPath, false)) {
+            journal.close();
+            std::cout << "[INFO] Failed to open journal: " << journalPath << std::endl;
+        }
+    }
+
+    // 向日志追加记录并落盘; 失败时不推进写入位置, 下一批记录覆盖写了一半的内容 (这批修改仍在脏区块中, 由下次自动保存写入)
+    void appendJournal(const std::vector<EditRecord>& records) {
+        if (records.empty()) return;
+        uint32_t bytes = (uint32_t)(records.size() * sizeof(EditRecord));
+        if (journal.write(journalBytes, records.data(), bytes) == (int64_t)bytes && journal.sync()) {
+            journalBytes += bytes;
+        }
+    }
+
+    void workerLoop() {
+        auto nextSave = std::chrono::steady_clock::now() + std::chrono::seconds(autosaveSeconds);
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+            wakeup.wait_for(lock, std::chrono::milliseconds(journalFlushMs), [this] { return stopping; });
+            if (stopping) break;
+            if (std::chrono::steady_clock::now() >= nextSave) {
+                lock.unlock();
+                autosave();
+                lock.lock();
+                nextSave = std::chrono::steady_clock::now() + std::chrono::seconds(autosaveSeconds);
+            } else if (!pendingRecords.empty()) {
+                std::vector<EditRecord> records;
+                records.swap(pendingRecords);
+                journalRecords += (int)records.size();
+                lock.unlock();
+                appendJournal(records);
+                lock.lock();
+            }
+        }
+    }
+};
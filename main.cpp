@@ -11,6 +11,7 @@
 #include <cmath>
 #include <vector>
 #include <sstream>
+#include <cstdlib>
 #include <GL/gl.h>
 #include <GL/glu.h>
 #include <GLFW/glfw3.h>
@@ -71,7 +72,8 @@ void initOpenGLSettings() {
 }
 
 // 主循环
-int main() {
+// 用法: minecraft_opengl.exe [种子], 不指定种子时随机生成; 同一种子的区块会从 cache/<种子>/ 载入
+int main(int argc, char* argv[]) {
     // 初始化 GLFW
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW!" << std::endl;
@@ -110,8 +112,10 @@ int main() {
     initOpenGLSettings();
 
     // 创建地图对象
-    World world(worldWidth, worldHeight, worldDepth);
-    world.generateWorldMap();  // 生成随机地图
+    int worldSeed = argc > 1 ? std::atoi(argv[1]) : (int)Random::timeSeed();
+    World world(worldWidth, worldHeight, worldDepth, worldSeed);
+    glm::vec3 spawnPosition(worldWidth / 2, worldHeight + 2, worldDepth / 2);
+    world.generateWorldMap(spawnPosition);  // 加载出生点附近的区块, 其余区块在游戏中流式生成
     std::cout << "World generated!" << std::endl;
 
     
@@ -127,7 +131,7 @@ int main() {
     glfwSetCursorPos(window, windowWidth / 2, windowHeight / 2);  // 设置初始位置（窗口的中心）
 
     // 创建摄像机对象, 设置鼠标回调函数
-    Player player(glm::vec3(worldWidth / 2, worldHeight + 2, worldDepth / 2), world, windowWidth, windowHeight);
+    Player player(spawnPosition, world, windowWidth, windowHeight);
     player.attachToWindow(window);
 
     // 初始化ImGui
@@ -166,9 +170,15 @@ int main() {
         glm::mat4 projection = glm::infinitePerspective(glm::radians(45.0f), windowWidth / windowHeight, 0.01f);
         DEBUG_LOG("[DEBUG] Created projection matrix");
 
+        // 推进区块流水线 (生成、网格构建、上传)
+        world.update(player.getCameraPosition(), player.getRayDirection(), player.getVelocity());
+        DEBUG_LOG("[DEBUG] Updated chunk pipeline");
+
         // 绘制地图和准心        
         world.render(view, projection);
         DEBUG_LOG("[DEBUG] Rendered world");
+        world.renderEntities(view, projection, player.getInterpolationAlpha());
+        DEBUG_LOG("[DEBUG] Rendered entities");
 
         crossHair.render();
         DEBUG_LOG("[DEBUG] Rendered crosshair");
@@ -215,6 +225,11 @@ int main() {
         player.inventory_render();
         DEBUG_LOG("[DEBUG] Rendered inventory");
 
+        // 调试信息 (F3)
+        if (player.isDebugInfoVisible()) {
+            world.renderDebugInfo();
+        }
+
         // 结束ImGui帧
         ImGui::Render();
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
@@ -224,10 +239,10 @@ int main() {
         glfwSwapBuffers(window);
         DEBUG_LOG("[DEBUG] Swapped buffers");
 
-        // 更新摄像机位置
+        // 更新摄像机位置 (固定步长模拟 + 插值)
         deltaTime = glfwGetTime() - lastFrameTime;
         lastFrameTime = glfwGetTime();
-        player.updatePosition(deltaTime);
+        player.update(deltaTime);
         DEBUG_LOG("[DEBUG] Updated player position");
 
         // 处理事件, 如键鼠输入
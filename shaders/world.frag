@@ -2,6 +2,8 @@
 
 in vec2 TexCoord;
 flat in int TextureType;
+in float SkyLight;
+in float BlockLight;
 
 out vec4 FragColor;
 
@@ -20,7 +22,10 @@ void main() {
         discard;
     }
     
-    vec3 dayNightBlendColor = vec3(dayNightBlendFactor);
+    // 每级光照亮度乘以 0.8; 天空光随昼夜变化, 方块光不受影响
+    float skyBrightness = pow(0.8, 15.0 - SkyLight) * dayNightBlendFactor;
+    float blockBrightness = pow(0.8, 15.0 - BlockLight);
+    vec3 lightColor = vec3(max(max(skyBrightness, blockBrightness), 0.03));
 
-    FragColor = vec4(textureColor.rgb * dayNightBlendColor, textureColor.a);
+    FragColor = vec4(textureColor.rgb * lightColor, textureColor.a);
 }
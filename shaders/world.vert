@@ -3,9 +3,12 @@
 layout(location = 0) in vec3 aPos;
 layout(location = 1) in vec2 aTexCoord;
 layout(location = 2) in float textureType;
+layout(location = 3) in float aLight; // 天空光 * 16 + 方块光
 
 out vec2 TexCoord;
 flat out int TextureType;
+out float SkyLight;
+out float BlockLight;
 
 uniform mat4 model;
 uniform mat4 view;
@@ -15,4 +18,6 @@ void main() {
     gl_Position = projection * view * vec4(aPos, 1.0);
     TexCoord = aTexCoord;
     TextureType = int(textureType);
+    SkyLight = floor(aLight / 16.0);
+    BlockLight = mod(aLight, 16.0);
 }
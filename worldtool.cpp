@@ -0,0 +1,848 @@
+// 离线世界工具 (无图形界面, 不依赖 OpenGL)
+// 用法:
+//   worldtool pregen <种子> [半径(区块), 默认整个世界] [线程数]   预生成出生点附近的区块并写入 cache/<种子>/
+//   worldtool load <种子> [线程数]                                 载入缓存中的全部区块, 测量冷启动载入耗时
+//   worldtool verify-determinism <种子>                           分别用 1、2 和硬件线程数个线程生成并装饰整个世界, 核对结果哈希相同
+//   worldtool verify-smoothing [种子...]                          逐区块平滑高度图的结果与整图参考实现逐列比较 (含区块边界)
+//   worldtool bench-region <种子> [线程数]                         测量区域文件的保存/载入吞吐量 (使用临时目录)
+//   worldtool bench-io <种子> [线程数] [每批区块数]                 比较 I/O 后端 (线程池 pread / io_uring) 的批量读写吞吐量和延迟
+//   worldtool bench-ray <种子> [每组射线数]                          测量批量射线查询的吞吐量 (与逐条遍历对比)
+//   worldtool bench-entities <种子> [实体数]                         测量实体物理每步的耗时 (积分、方块碰撞、实体间分离)
+//   worldtool bench-density <种子>                                   比较三维密度的粗网格格点 + 三线性插值与逐格子求噪声的耗时和结果差异
+//   worldtool bench-fluid <种子> [线程数]                            测量水流模拟的耗时与活跃格子数的关系, 并核对多线程结果与单线程一致
+//   worldtool bench-light <种子> [编辑次数]                          测量区块光照计算和每次编辑增量更新光照的耗时, 并与重新计算的结果核对
+//   worldtool bench-path <种子> [请求数] [线程数]                    测量分层寻路的吞吐量 (每秒路径数), 与直接在格子上做 A* 对比
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <thread>
+#include "Chunk.hpp"
+#include "ChunkCache.hpp"
+#include "ThreadPool.hpp"
+#include "WorldGenerator.hpp"
+#include "Raycast.hpp"
+#include "EntitySystem.hpp"
+#include "FluidSimulation.hpp"
+#include "LightEngine.hpp"
+#include "PathService.hpp"
+#include "ChunkSection.hpp"
+
+const int worldWidth = 600, worldHeight = 28, worldDepth = 600; // 地图大小 (与 main.cpp 一致)
+
+using Clock = std::chrono::steady_clock;
+
+double elapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// 出生点 (世界中央) 到区块上最近一点的距离 (区块单位), 出生点所在区块为 0
+float spawnDistance(const ChunkGrid& grid, const Chunk& chunk) {
+    float scx = grid.worldWidth / 2.0f / CHUNK_SIZE, scz = grid.worldDepth / 2.0f / CHUNK_SIZE;
+    float dx = std::max({ chunk.cx - scx, scx - (chunk.cx + 1), 0.0f });
+    float dz = std::max({ chunk.cz - scz, scz - (chunk.cz + 1), 0.0f });
+    return std::sqrt(dx * dx + dz * dz);
+}
+
+// 区块在内存中的数据量 (方块、高度图、生物群系), 用于计算 MB/s
+double chunkBytes() {
+    return CHUNK_SIZE * CHUNK_SIZE * (worldHeight + sizeof(int) + sizeof(float));
+}
+
+int pregen(int seed, float radius, int threads) {
+    ChunkGrid grid(worldWidth, worldHeight, worldDepth);
+    WorldGenerator generator(seed, worldWidth, worldHeight, worldDepth);
+    ChunkCache cache("cache", seed, worldHeight, WorldGenerator::version);
+    ThreadPool pool(threads);
+    std::cout << "[INFO] Pre-generating seed " << seed << " with " << pool.threadCount() << " threads into " << cache.getDirectory() << std::endl;
+
+    Clock::time_point start = Clock::now();
+    std::atomic<int> loaded{0}, generated{0}, saved{0};
+
+    // 第一步: 载入或生成半径内的区块, 外加两圈邻居 (装饰需要 3x3 区块都已生成)
+    for (Chunk& chunk : grid.chunks) {
+        if (spawnDistance(grid, chunk) > radius + 2) continue;
+        pool.submit({ 0.0f, 0, [&]() {
+            if (cache.load(chunk)) {
+                chunk.state.store(CHUNK_DECORATED);
+                loaded++;
+            } else {
+                generator.generateChunk(chunk);
+                chunk.state.store(CHUNK_GENERATED);
+                generated++;
+            }
+        }, nullptr });
+    }
+    pool.waitIdle();
+    double generateMs = elapsedMs(start);
+
+    // 第二步: 装饰半径内新生成的区块并写入缓存 (装饰只写入本区块, 可以并行)
+    for (Chunk& chunk : grid.chunks) {
+        if (spawnDistance(grid, chunk) > radius || chunk.state.load() != CHUNK_GENERATED) continue;
+        pool.submit({ 0.0f, 0, [&]() {
+            generator.decorateChunk(grid, chunk);
+            chunk.state.store(CHUNK_DECORATED);
+            if (cache.save(chunk)) saved++;
+        }, nullptr });
+    }
+    pool.waitIdle();
+
+    double ms = elapsedMs(start);
+    std::cout << "[INFO] Generated " << generated << " chunks, saved " << saved << ", already cached " << loaded
+              << " in " << ms << " ms (" << (generated + loaded) / (ms / 1000.0) << " chunks/s)" << std::endl;
+    // 地形生成阶段 (含缓存载入) 每秒处理的列数, 一个区块 CHUNK_SIZE * CHUNK_SIZE 列
+    long long columns = (long long)(generated + loaded) * CHUNK_SIZE * CHUNK_SIZE;
+    std::cout << "[INFO] Terrain pass: " << columns << " columns in " << generateMs << " ms ("
+              << columns / (generateMs / 1000.0) << " columns/s)" << std::endl;
+    return 0;
+}
+
+int load(int seed, int threads) {
+    ChunkGrid grid(worldWidth, worldHeight, worldDepth);
+    ChunkCache cache("cache", seed, worldHeight, WorldGenerator::version);
+    ThreadPool pool(threads);
+
+    Clock::time_point start = Clock::now();
+    std::atomic<int> loaded{0};
+    for (Chunk& chunk : grid.chunks) {
+        pool.submit({ 0.0f, 0, [&]() {
+            if (cache.load(chunk)) loaded++;
+        }, nullptr });
+    }
+    pool.waitIdle();
+
+    double ms = elapsedMs(start);
+    double megabytes = loaded * chunkBytes() / (1024.0 * 1024.0);
+    std::cout << "[INFO] Loaded " << loaded << " / " << grid.chunks.size() << " chunks from " << cache.getDirectory()
+              << " in " << ms << " ms (" << loaded / (ms / 1000.0) << " chunks/s, " << megabytes / (ms / 1000.0) << " MB/s)" << std::endl;
+    return 0;
+}
+
+// 在内存中生成并装饰整个世界
+void generateAll(ChunkGrid& grid, int seed, ThreadPool& pool) {
+    WorldGenerator generator(seed, worldWidth, worldHeight, worldDepth);
+    for (Chunk& chunk : grid.chunks) {
+        pool.submit({ 0.0f, 0, [&]() { generator.generateChunk(chunk); }, nullptr });
+    }
+    pool.waitIdle();
+    for (Chunk& chunk : grid.chunks) {
+        pool.submit({ 0.0f, 0, [&]() { generator.decorateChunk(grid, chunk); }, nullptr });
+    }
+    pool.waitIdle();
+}
+
+// 整个世界的内容哈希 (方块、高度图、生物群系), 用于比较不同线程数下的生成结果
+uint64_t worldHash(const ChunkGrid& grid) {
+    uint64_t hash = SectionStore::hashBytes(nullptr, 0);
+    for (const Chunk& chunk : grid.chunks) {
+        hash = SectionStore::hashBytes(chunk.blocks.data(), chunk.blocks.size(), hash);
+        hash = SectionStore::hashBytes(reinterpret_cast<const uint8_t*>(chunk.heightMap.data()), chunk.heightMap.size() * sizeof(int), hash);
+        hash = SectionStore::hashBytes(reinterpret_cast<const uint8_t*>(chunk.biomeMap.data()), chunk.biomeMap.size() * sizeof(float), hash);
+    }
+    return hash;
+}
+
+// 分别用 1、2 和硬件线程数个线程生成并装饰整个世界, 结果的哈希必须完全相同
+int verifyDeterminism(int seed) {
+    std::vector<int> threadCounts = { 1, 2, std::max(1, (int)std::thread::hardware_concurrency()) };
+    std::sort(threadCounts.begin(), threadCounts.end());
+    threadCounts.erase(std::unique(threadCounts.begin(), threadCounts.end()), threadCounts.end());
+
+    uint64_t expected = 0;
+    bool mismatch = false;
+    for (size_t i = 0; i < threadCounts.size(); ++i) {
+        ChunkGrid grid(worldWidth, worldHeight, worldDepth);
+        ThreadPool pool(threadCounts[i]);
+        Clock::time_point start = Clock::now();
+        generateAll(grid, seed, pool);
+        double ms = elapsedMs(start);
+        uint64_t hash = worldHash(grid);
+        if (i == 0) expected = hash;
+        mismatch = mismatch || hash != expected;
+        std::cout << "[INFO] " << pool.threadCount() << " threads: world hash " << std::hex << hash << std::dec
+                  << " in " << ms << " ms" << (hash == expected ? "" : " (MISMATCH)") << std::endl;
+    }
+    if (mismatch) {
+        std::cerr << "[ERROR] World generation for seed " << seed << " depends on the thread count" << std::endl;
+        return 1;
+    }
+    std::cout << "[INFO] World generation for seed " << seed << " is deterministic across " << threadCounts.size() << " thread counts" << std::endl;
+    return 0;
+}
+
+/*
+    参考实现: 对整张原始高度图做平滑 (分块实现之前的写法, 每次扫描复制整张 vector<vector<int>>)
+    世界边缘不调整; 比某个邻居低 maxDelta 以上的点提升到两者中间, 多个邻居满足条件时以最后一个为准
+*/
+std::vector<std::vector<int>> referenceSmooth(const WorldGenerator& generator) {
+    std::vector<float> terrainValues(worldWidth * worldDepth), biomeValues(worldWidth * worldDepth);
+    generator.terrainNoise.fill(0, 0, worldWidth, worldDepth, terrainValues.data());
+    generator.biomeNoise.fill(0, 0, worldWidth, worldDepth, biomeValues.data());
+
+    std::vector<std::vector<int>> heightMap(worldWidth, std::vector<int>(worldDepth, 0));
+    for (int x = 0; x < worldWidth; ++x) {
+        for (int z = 0; z < worldDepth; ++z) {
+            heightMap[x][z] = generator.rawHeight(terrainValues[x * worldDepth + z], biomeValues[x * worldDepth + z]);
+        }
+    }
+
+    const int maxDelta = generator.smoothMaxDelta;
+    for (int iter = 0; iter < generator.smoothIterations; ++iter) {
+        std::vector<std::vector<int>> newHeightMap = heightMap; // 临时存储新的高度值
+        for (int x = 1; x < worldWidth - 1; ++x) {
+            for (int z = 1; z < worldDepth - 1; ++z) {
+                int currentHeight = heightMap[x][z];
+                for (int dx = -1; dx <= 1; ++dx) {
+                    for (int dz = -1; dz <= 1; ++dz) {
+                        if (dx == 0 && dz == 0) continue;
+                        int neighborHeight = heightMap[x + dx][z + dz];
+                        if (currentHeight < neighborHeight - maxDelta) {
+                            newHeightMap[x][z] = currentHeight + (neighborHeight - currentHeight) / 2;
+                        }
+                    }
+                }
+            }
+        }
+        heightMap = newHeightMap;
+    }
+    return heightMap;
+}
+
+// 逐区块 (外扩 halo 的扁平缓冲区) 平滑的结果与整图参考实现逐列比较, 区块边界一圈的列单独统计
+int verifySmoothing(const std::vector<int>& seeds) {
+    bool mismatch = false;
+    for (int seed : seeds) {
+        WorldGenerator generator(seed, worldWidth, worldHeight, worldDepth);
+        Clock::time_point start = Clock::now();
+        std::vector<std::vector<int>> reference = referenceSmooth(generator);
+        double referenceMs = elapsedMs(start);
+
+        const int chunksX = (worldWidth + CHUNK_SIZE - 1) / CHUNK_SIZE, chunksZ = (worldDepth + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        long long columns = 0, borderColumns = 0, differ = 0, borderDiffer = 0;
+        double tiledMs = 0.0;
+        for (int cx = 0; cx < chunksX; ++cx) {
+            for (int cz = 0; cz < chunksZ; ++cz) {
+                int heights[CHUNK_SIZE * CHUNK_SIZE];
+                float biomes[CHUNK_SIZE * CHUNK_SIZE];
+                start = Clock::now();
+                generator.terrainHeights(cx, cz, heights, biomes);
+                tiledMs += elapsedMs(start);
+                for (int lx = 0; lx < CHUNK_SIZE && cx * CHUNK_SIZE + lx < worldWidth; ++lx) {
+                    for (int lz = 0; lz < CHUNK_SIZE && cz * CHUNK_SIZE + lz < worldDepth; ++lz) {
+                        bool border = lx == 0 || lz == 0 || lx == CHUNK_SIZE - 1 || lz == CHUNK_SIZE - 1;
+                        bool same = heights[lx * CHUNK_SIZE + lz] == reference[cx * CHUNK_SIZE + lx][cz * CHUNK_SIZE + lz];
+                        columns++;
+                        borderColumns += border;
+                        differ += !same;
+                        borderDiffer += border && !same;
+                    }
+                }
+            }
+        }
+        mismatch = mismatch || differ > 0;
+        std::cout << "[INFO] Seed " << seed << ": " << differ << " / " << columns << " columns differ ("
+                  << borderDiffer << " / " << borderColumns << " on chunk borders); reference " << referenceMs
+                  << " ms, tiled " << tiledMs << " ms" << std::endl;
+    }
+    if (mismatch) {
+        std::cerr << "[ERROR] Tiled smoothing differs from the reference implementation" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+/*
+    三维密度: 粗网格格点求值 + 三线性插值 (fillDensity) 与逐格子调用 GetNoise 对比
+    两者用同一张平滑后的高度图, 统计耗时、噪声求值次数和实心判定不同的格子比例
+*/
+int benchDensity(int seed) {
+    WorldGenerator generator(seed, worldWidth, worldHeight, worldDepth);
+    const int chunksX = (worldWidth + CHUNK_SIZE - 1) / CHUNK_SIZE, chunksZ = (worldDepth + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    std::vector<uint8_t> lattice(CHUNK_SIZE * CHUNK_SIZE * worldHeight), perVoxel(lattice.size());
+    double latticeMs = 0.0, perVoxelMs = 0.0;
+    long long latticeEvaluations = 0, perVoxelEvaluations = 0, cells = 0, differ = 0;
+
+    for (int cx = 0; cx < chunksX; ++cx) {
+        for (int cz = 0; cz < chunksZ; ++cz) {
+            int heights[CHUNK_SIZE * CHUNK_SIZE] = {};
+            float biomes[CHUNK_SIZE * CHUNK_SIZE];
+            generator.terrainHeights(cx, cz, heights, biomes);
+            const int chunkWidth = std::min(worldWidth, cx * CHUNK_SIZE + CHUNK_SIZE) - cx * CHUNK_SIZE;
+            const int chunkDepth = std::min(worldDepth, cz * CHUNK_SIZE + CHUNK_SIZE) - cz * CHUNK_SIZE;
+
+            Clock::time_point start = Clock::now();
+            latticeEvaluations += generator.fillDensity(heights, CHUNK_SIZE, 0, 0, cx, cz, chunkWidth, chunkDepth, lattice.data());
+            latticeMs += elapsedMs(start);
+
+            start = Clock::now();
+            for (int lx = 0; lx < chunkWidth; ++lx) {
+                for (int lz = 0; lz < chunkDepth; ++lz) {
+                    const int h = heights[lx * CHUNK_SIZE + lz];
+                    for (int y = 0; y < worldHeight; ++y) {
+                        float noise = generator.densityNoise.GetNoise((float)(cx * CHUNK_SIZE + lx), (float)y, (float)(cz * CHUNK_SIZE + lz));
+                        perVoxel[ChunkGrid::blockIndex(lx, y, lz)] = y == 0 || (h - y) + generator.densityAmplitude * noise > 0.0f;
+                    }
+                }
+            }
+            perVoxelMs += elapsedMs(start);
+            perVoxelEvaluations += (long long)chunkWidth * chunkDepth * worldHeight;
+
+            for (int lx = 0; lx < chunkWidth; ++lx) {
+                for (int lz = 0; lz < chunkDepth; ++lz) {
+                    for (int y = 0; y < worldHeight; ++y) {
+                        int index = ChunkGrid::blockIndex(lx, y, lz);
+                        differ += lattice[index] != perVoxel[index];
+                        cells++;
+                    }
+                }
+            }
+        }
+    }
+
+    const int chunkCount = chunksX * chunksZ;
+    std::cout << "[INFO] " << chunkCount << " chunks, " << cells << " cells" << std::endl;
+    std::cout << "[INFO] Lattice + trilinear: " << latticeMs / chunkCount * 1000.0 << " us/chunk, "
+              << (double)latticeEvaluations / chunkCount << " noise evaluations/chunk" << std::endl;
+    std::cout << "[INFO] Per-voxel GetNoise: " << perVoxelMs / chunkCount * 1000.0 << " us/chunk, "
+              << (double)perVoxelEvaluations / chunkCount << " noise evaluations/chunk" << std::endl;
+    std::cout << "[INFO] Speedup " << perVoxelMs / latticeMs << "x; " << differ << " cells (" << (double)differ / cells * 100.0
+              << "%) solid in only one of them" << std::endl;
+    return 0;
+}
+
+// 第 p 百分位 (0..1) 的值
+float percentile(std::vector<float> values, float p) {
+    if (values.empty()) return 0.0f;
+    size_t index = std::min(values.size() - 1, (size_t)(p * values.size()));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
+
+int benchRegion(int seed, int threads) {
+    ChunkGrid grid(worldWidth, worldHeight, worldDepth);
+    ThreadPool pool(threads);
+    generateAll(grid, seed, pool);
+
+    const std::string root = "cache/bench";
+    std::error_code error;
+    std::filesystem::remove_all(root, error);
+    const double megabytes = grid.chunks.size() * chunkBytes() / (1024.0 * 1024.0);
+
+    long long diskBytes = 0;
+    {
+        ChunkCache cache(root, seed, worldHeight, WorldGenerator::version);
+        Clock::time_point start = Clock::now();
+        for (Chunk& chunk : grid.chunks) {
+            pool.submit({ 0.0f, 0, [&]() { cache.save(chunk); }, nullptr });
+        }
+        pool.waitIdle();
+        double ms = elapsedMs(start);
+        diskBytes = cache.diskBytes();
+        std::cout << "[INFO] Save: " << grid.chunks.size() << " chunks in " << ms << " ms ("
+                  << grid.chunks.size() / (ms / 1000.0) << " chunks/s, " << megabytes / (ms / 1000.0) << " MB/s)" << std::endl;
+    }
+
+    ChunkGrid loadedGrid(worldWidth, worldHeight, worldDepth);
+    ChunkCache cache(root, seed, worldHeight, WorldGenerator::version); // 重新打开, 从映射读取
+    std::atomic<int> mismatched{0};
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < (int)grid.chunks.size(); ++i) {
+        pool.submit({ 0.0f, 0, [&, i]() {
+            Chunk& chunk = loadedGrid.chunks[i];
+            if (!cache.load(chunk) || chunk.blocks != grid.chunks[i].blocks) mismatched++;
+        }, nullptr });
+    }
+    pool.waitIdle();
+    double ms = elapsedMs(start);
+    std::cout << "[INFO] Load: " << grid.chunks.size() << " chunks in " << ms << " ms ("
+              << grid.chunks.size() / (ms / 1000.0) << " chunks/s, " << megabytes / (ms / 1000.0) << " MB/s), "
+              << mismatched << " mismatched" << std::endl;
+    std::cout << "[INFO] Disk: " << diskBytes / 1024 << " KB for " << megabytes * 1024.0 << " KB of chunk data (ratio "
+              << megabytes * 1024.0 * 1024.0 / diskBytes << ")" << std::endl;
+    std::filesystem::remove_all(root, error);
+    return 0;
+}
+
+int benchIO(int seed, int threads, int batchSize) {
+    ChunkGrid grid(worldWidth, worldHeight, worldDepth);
+    {
+        ThreadPool pool(threads);
+        generateAll(grid, seed, pool);
+    }
+    const std::string root = "cache/bench-io";
+    const RegionFile::FileHeader header = ChunkCache::makeHeader(seed, worldHeight, WorldGenerator::version);
+    const bool direct = true; // 绕过页缓存, 测量真实的磁盘读写
+
+    for (const char* backendName : { "pool", "uring" }) {
+        std::unique_ptr<ChunkIOBackend> backend = createChunkIOBackend(backendName, threads);
+        std::error_code error;
+        std::filesystem::remove_all(root, error);
+
+        // 保存
+        std::vector<float> latencies;
+        long long diskBytes = 0;
+        Clock::time_point start = Clock::now();
+        {
+            RegionStorage storage(root, header);
+            for (size_t first = 0; first < grid.chunks.size(); first += batchSize) {
+                std::vector<const Chunk*> batch;
+                for (size_t i = first; i < std::min(grid.chunks.size(), first + batchSize); ++i) {
+                    batch.push_back(&grid.chunks[i]);
+                }
+                storage.saveBatch(batch, *backend, direct, &latencies);
+            }
+            diskBytes = storage.diskBytes();
+        }
+        double ms = elapsedMs(start);
+        double megabytes = diskBytes / (1024.0 * 1024.0);
+        std::cout << "[INFO] " << backend->name() << " save: " << grid.chunks.size() / (ms / 1000.0) << " chunks/s, "
+                  << megabytes / (ms / 1000.0) << " MB/s, latency p50 " << percentile(latencies, 0.5f)
+                  << " ms p99 " << percentile(latencies, 0.99f) << " ms" << std::endl;
+
+        // 载入 (重新打开区域文件)
+        ChunkGrid loadedGrid(worldWidth, worldHeight, worldDepth);
+        RegionStorage storage(root, header);
+        latencies.clear();
+        int loaded = 0, mismatched = 0;
+        start = Clock::now();
+        for (size_t first = 0; first < loadedGrid.chunks.size(); first += batchSize) {
+            std::vector<Chunk*> batch;
+            for (size_t i = first; i < std::min(loadedGrid.chunks.size(), first + batchSize); ++i) {
+                batch.push_back(&loadedGrid.chunks[i]);
+            }
+            std::vector<char> batchLoaded;
+            loaded += storage.loadBatch(batch, *backend, direct, batchLoaded, &latencies);
+        }
+        ms = elapsedMs(start);
+        for (size_t i = 0; i < grid.chunks.size(); ++i) {
+            if (loadedGrid.chunks[i].blocks != grid.chunks[i].blocks) mismatched++;
+        }
+        std::cout << "[INFO] " << backend->name() << " load: " << loaded / (ms / 1000.0) << " chunks/s, "
+                  << megabytes / (ms / 1000.0) << " MB/s, latency p50 " << percentile(latencies, 0.5f)
+                  << " ms p99 " << percentile(latencies, 0.99f) << " ms, " << mismatched << " mismatched" << std::endl;
+    }
+    std::error_code error;
+    std::filesystem::remove_all(root, error);
+    return 0;
+}
+
+// 地表高度 (最高的非空气方块)
+int surfaceHeight(const ChunkGrid& grid, int x, int z) {
+    int y = worldHeight - 1;
+    while (y > 0 && grid.getBlock(x, y, z) == BLOCK_AIR) --y;
+    return y;
+}
+
+int benchRay(int seed, int rayCount) {
+    ChunkGrid grid(worldWidth, worldHeight, worldDepth);
+    {
+        ThreadPool pool(0);
+        generateAll(grid, seed, pool);
+    }
+    VoxelOccupancy occupancy(worldWidth, worldHeight, worldDepth);
+    for (const Chunk& chunk : grid.chunks) {
+        occupancy.build(chunk, worldHeight);
+    }
+    std::cout << "[INFO] Occupancy: " << occupancy.emptyFraction() * 100.0f << "% of bricks empty" << std::endl;
+
+    // 几种典型的查询: 准星 (7 格), 水平视线 (64 格), 地面向上的环境光遮蔽采样 (16 格), 从世界上方向下 (64 格)
+    const char* names[] = { "crosshair", "sight lines", "AO hemisphere", "from above" };
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    for (int kind = 0; kind < 4; ++kind) {
+        std::vector<Ray> rays(rayCount);
+        for (Ray& ray : rays) {
+            float x = 20.0f + uniform(random) * (worldWidth - 40), z = 20.0f + uniform(random) * (worldDepth - 40);
+            float surface = (float)surfaceHeight(grid, (int)x, (int)z);
+            float dx = uniform(random) * 2.0f - 1.0f, dz = uniform(random) * 2.0f - 1.0f;
+            if (kind == 0) ray = { glm::vec3(x, surface + 1.6f, z), glm::vec3(dx, uniform(random) * 2.0f - 1.3f, dz), 7.0f };
+            if (kind == 1) ray = { glm::vec3(x, surface + 1.6f, z), glm::vec3(dx, (uniform(random) * 2.0f - 1.0f) * 0.1f, dz), 64.0f };
+            if (kind == 2) ray = { glm::vec3(x, surface + 1.01f, z), glm::vec3(dx, uniform(random) + 0.05f, dz), 16.0f };
+            if (kind == 3) ray = { glm::vec3(x, worldHeight + 12.0f, z), glm::vec3(dx, -0.3f - uniform(random), dz), 64.0f };
+            ray.direction = glm::normalize(ray.direction);
+        }
+
+        // 交替测量多次取最快的一次, 减少其他进程的干扰
+        std::vector<RayHit> single(rayCount), batch(rayCount);
+        double singleMs = 1e30, batchMs = 1e30;
+        size_t hits = 0;
+        for (int repeat = 0; repeat < 10; ++repeat) {
+            Clock::time_point start = Clock::now();
+            for (int i = 0; i < rayCount; ++i) {
+                single[i] = RayHit();
+                raycastVoxels(rays[i].origin, rays[i].direction, rays[i].maxDistance, [&](int x, int y, int z) { return grid.getBlock(x, y, z); }, single[i]);
+            }
+            singleMs = std::min(singleMs, elapsedMs(start));
+            start = Clock::now();
+            hits = raycastBatch(grid, occupancy, rays.data(), rays.size(), batch.data());
+            batchMs = std::min(batchMs, elapsedMs(start));
+        }
+        int mismatched = 0;
+        for (int i = 0; i < rayCount; ++i) {
+            if (single[i].type != batch[i].type || single[i].block != batch[i].block || single[i].normal != batch[i].normal) mismatched++;
+        }
+        std::cout << "[INFO] " << names[kind] << ": " << rayCount << " rays, " << hits * 100.0 / rayCount << "% hit, batch "
+                  << rayCount / (batchMs / 1000.0) / 1e6 << " M rays/s, one at a time " << rayCount / (singleMs / 1000.0) / 1e6
+                  << " M rays/s, " << mismatched << " mismatched" << std::endl;
+    }
+    return 0;
+}
+
+int benchEntities(int seed, int entityCount) {
+    ChunkGrid grid(worldWidth, worldHeight, worldDepth);
+    {
+        ThreadPool pool(0);
+        generateAll(grid, seed, pool);
+    }
+    // 世界的水平边界之外视为实心, 实体不会掉出世界
+    auto isSolid = [&](int x, int y, int z) {
+        if (x < 0 || z < 0 || x >= worldWidth || z >= worldDepth || y < 0) return true;
+        return grid.getBlock(x, y, z) != BLOCK_AIR;
+    };
+
+    // 实体散布在出生点附近 64x64 的地表上方, 带随机的水平速度, 密度足以产生大量碰撞
+    EntitySystem entities;
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    const float areaSize = 64.0f, x0 = worldWidth / 2 - areaSize / 2, z0 = worldDepth / 2 - areaSize / 2;
+    auto isInsideBlock = [&](const glm::vec3& minBound, const glm::vec3& maxBound) {
+        for (int x = firstOverlappedCell(minBound.x); x <= lastOverlappedCell(maxBound.x); ++x)
+            for (int y = firstOverlappedCell(minBound.y); y <= lastOverlappedCell(maxBound.y); ++y)
+                for (int z = firstOverlappedCell(minBound.z); z <= lastOverlappedCell(maxBound.z); ++z)
+                    if (isSolid(x, y, z)) return true;
+        return false;
+    };
+    while (entities.size() < entityCount) {
+        float x = x0 + uniform(random) * areaSize, z = z0 + uniform(random) * areaSize;
+        float y = surfaceHeight(grid, (int)x, (int)z) + 1.0f + uniform(random) * 8.0f;
+        glm::vec3 velocity((uniform(random) - 0.5f) * 8.0f, 0.0f, (uniform(random) - 0.5f) * 8.0f);
+        bool small = uniform(random) < 0.5f; // 一半是掉落物大小, 一半是生物大小
+        float width = small ? 0.25f : 0.6f, height = small ? 0.25f : 1.8f;
+        glm::vec3 position(x, y, z), half(width * 0.5f, 0.0f, width * 0.5f);
+        if (isInsideBlock(position - half, position + half + glm::vec3(0.0f, height, 0.0f))) continue; // 与相邻的树冠重叠
+        entities.spawn(position, velocity, width, height);
+    }
+
+    const float dt = 1.0f / 60.0f;
+    const int ticks = 600;
+    double integrateMs = 0.0, collideMs = 0.0, separateMs = 0.0, firstSecondMs = 0.0, lastSecondMs = 0.0;
+    long long awakeTotal = 0, contactsTotal = 0;
+    for (int tick = 0; tick < ticks; ++tick) {
+        Clock::time_point start = Clock::now();
+        entities.integrate(dt);
+        Clock::time_point integrated = Clock::now();
+        entities.collide(dt, isSolid);
+        Clock::time_point collided = Clock::now();
+        entities.separate();
+        double tickMs = elapsedMs(start);
+        integrateMs += std::chrono::duration<double, std::milli>(integrated - start).count();
+        collideMs += std::chrono::duration<double, std::milli>(collided - integrated).count();
+        separateMs += std::chrono::duration<double, std::milli>(Clock::now() - collided).count();
+        if (tick < 60) firstSecondMs += tickMs;
+        if (tick >= ticks - 60) lastSecondMs += tickMs;
+        awakeTotal += entities.lastAwake;
+        contactsTotal += entities.lastContacts;
+    }
+
+    int inside = 0;
+    for (int i = 0; i < entities.size(); ++i) {
+        if (isInsideBlock(entities.getMinBound(i), entities.getMaxBound(i))) inside++;
+    }
+
+    double perThousand = 1000.0 / entityCount;
+    std::cout << "[INFO] " << entityCount << " entities, " << ticks << " ticks: avg " << awakeTotal / (double)ticks << " awake, "
+              << contactsTotal / (double)ticks << " contacts per tick" << std::endl;
+    std::cout << "[INFO] Per tick per 1000 entities: integrate " << integrateMs / ticks * perThousand * 1000.0 << " us, collide "
+              << collideMs / ticks * perThousand * 1000.0 << " us, separate " << separateMs / ticks * perThousand * 1000.0 << " us" << std::endl;
+    std::cout << "[INFO] Per tick per 1000 entities: first second (all awake) " << firstSecondMs / 60 * perThousand * 1000.0
+              << " us, last second " << lastSecondMs / 60 * perThousand * 1000.0 << " us" << std::endl;
+    std::cout << "[INFO] Entities inside blocks at the end: " << inside << std::endl;
+    return 0;
+}
+
+int benchFluid(int seed, int threads) {
+    ChunkGrid grid(worldWidth, worldHeight, worldDepth);
+    {
+        ThreadPool pool(0);
+        generateAll(grid, seed, pool);
+    }
+    std::vector<std::vector<uint8_t>> original;
+    for (const Chunk& chunk : grid.chunks) {
+        original.push_back(chunk.blocks);
+    }
+    auto worldHash = [&]() {
+        uint64_t hash = SectionStore::hashBytes(nullptr, 0);
+        for (const Chunk& chunk : grid.chunks) hash = SectionStore::hashBytes(chunk.blocks.data(), chunk.blocks.size(), hash);
+        return hash;
+    };
+
+    // 在出生点附近的地表上方放置水源, 模拟到水流静止; 分别用单线程和多线程运行, 结果应完全相同
+    for (int sources : { 0, 1, 16, 256 }) {
+        uint64_t hashes[2] = { 0, 0 };
+        for (int run = 0; run < 2; ++run) {
+            for (size_t i = 0; i < grid.chunks.size(); ++i) {
+                grid.chunks[i].blocks = original[i];
+            }
+            FluidSimulation fluids(grid, run == 0 ? 1 : threads);
+            std::mt19937 random(seed);
+            std::uniform_int_distribution<int> offset(-96, 96);
+            for (int i = 0; i < sources; ++i) {
+                int x = worldWidth / 2 + offset(random), z = worldDepth / 2 + offset(random);
+                int y = std::min(worldHeight - 1, surfaceHeight(grid, x, z) + 1);
+                grid.setBlock(x, y, z, WATER_BLOCK);
+                fluids.activate(x, y, z);
+            }
+
+            std::vector<FluidSimulation::Change> changes;
+            double totalMs = 0.0, maxMs = 0.0;
+            long long cellUpdates = 0, changed = 0;
+            int steps = 0, maxChunks = 0;
+            while (steps < 1000) {
+                fluids.step(changes, [](const Chunk&) { return true; });
+                for (const FluidSimulation::Change& change : changes) {
+                    grid.setBlock(change.x, change.y, change.z, change.type);
+                }
+                steps++;
+                totalMs += fluids.lastStepMs;
+                maxMs = std::max(maxMs, fluids.lastStepMs);
+                cellUpdates += fluids.lastActiveCells;
+                changed += fluids.lastChanged;
+                maxChunks = std::max(maxChunks, fluids.lastActiveChunks);
+                changes.clear();
+                if (fluids.activeCount() == 0) break;
+            }
+            hashes[run] = worldHash();
+            std::cout << "[INFO] " << sources << " sources, " << (run == 0 ? 1 : fluids.threadCount()) << " threads: " << steps << " steps to settle, "
+                      << cellUpdates << " cell updates (" << changed << " changed, up to " << maxChunks << " chunks per step), "
+                      << totalMs << " ms total, max step " << maxMs << " ms, " << (cellUpdates > 0 ? totalMs * 1e6 / cellUpdates : 0.0) << " ns per cell" << std::endl;
+        }
+        std::cout << "[INFO] " << sources << " sources: single-threaded and multi-threaded results " << (hashes[0] == hashes[1] ? "match" : "DIFFER") << std::endl;
+    }
+    return 0;
+}
+
+int benchLight(int seed, int editCount) {
+    ChunkGrid grid(worldWidth, worldHeight, worldDepth);
+    {
+        ThreadPool pool(0);
+        generateAll(grid, seed, pool);
+    }
+
+    // 整个世界的初始光照 (游戏中在构建网格阶段逐区块计算)
+    LightEngine lighting(grid);
+    std::vector<uint8_t> padded;
+    Clock::time_point start = Clock::now();
+    for (Chunk& chunk : grid.chunks) {
+        lighting.computeChunk(chunk, padded);
+    }
+    double computeMs = elapsedMs(start);
+    for (Chunk& chunk : grid.chunks) {
+        chunk.state.store(CHUNK_MESHED);
+    }
+    std::cout << "[INFO] Computed light for " << grid.chunks.size() << " chunks in " << computeMs << " ms ("
+              << computeMs / grid.chunks.size() << " ms per chunk)" << std::endl;
+
+    // 出生点附近的随机编辑: 挖开地表、在地表上加盖石头、放置发光方块、在地下挖洞
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<int> offset(-160, 160);
+    std::vector<float> editMs;
+    std::vector<glm::ivec2> remesh;
+    long long cells = 0, remeshed = 0;
+    int maxCells = 0;
+    for (int i = 0; i < editCount; ++i) {
+        int x = worldWidth / 2 + offset(random), z = worldDepth / 2 + offset(random);
+        int surface = surfaceHeight(grid, x, z);
+        int y = surface;
+        BlockType type = BlockType::BLOCK_AIR;
+        switch (i % 4) {
+        case 0: break;
+        case 1: y = std::min(worldHeight - 1, surface + 1); type = STONE_BLOCK; break;
+        case 2: y = std::min(worldHeight - 1, surface + 1); type = GLOWSTONE; break;
+        case 3: y = std::max(0, surface - 3); break;
+        }
+        grid.setBlock(x, y, z, type);
+        remesh.clear();
+        lighting.update(x, y, z, remesh);
+        editMs.push_back((float)lighting.lastUpdateMs);
+        cells += lighting.lastUpdatedCells;
+        maxCells = std::max(maxCells, lighting.lastUpdatedCells);
+        remeshed += remesh.size();
+    }
+    double totalMs = 0.0;
+    for (float ms : editMs) totalMs += ms;
+    std::cout << "[INFO] " << editCount << " edits: avg " << totalMs / editCount * 1000.0 << " us, p50 " << percentile(editMs, 0.5f) * 1000.0f
+              << " us, p99 " << percentile(editMs, 0.99f) * 1000.0f << " us, max " << lighting.maxUpdateMs * 1000.0 << " us; "
+              << (double)cells / editCount << " cell writes per edit (max " << maxCells << "), "
+              << (double)remeshed / editCount << " chunks to remesh per edit" << std::endl;
+
+    // 核对: 增量更新后的光照应与按当前方块重新计算的结果相同
+    long long mismatched = 0, total = 0;
+    for (Chunk& chunk : grid.chunks) {
+        std::vector<uint8_t> incremental = chunk.light;
+        lighting.computeChunk(chunk, padded);
+        for (size_t i = 0; i < incremental.size(); ++i) {
+            if (incremental[i] != chunk.light[i]) mismatched++;
+        }
+        total += incremental.size();
+    }
+    std::cout << "[INFO] Incremental vs recomputed light: " << mismatched << " of " << total << " cells differ" << std::endl;
+    return mismatched == 0 ? 0 : 1;
+}
+
+int benchPath(int seed, int requestCount, int threads) {
+    ChunkGrid grid(worldWidth, worldHeight, worldDepth);
+    {
+        ThreadPool pool(0);
+        generateAll(grid, seed, pool);
+    }
+    PathService paths(grid, threads);
+    auto allReady = [](const Chunk&) { return true; };
+    paths.refresh(allReady);
+    std::cout << "[INFO] Built path graph for " << paths.builtChunks() << " chunks (" << paths.regionCount() << " regions) in "
+              << paths.lastRefreshMs << " ms with " << paths.threadCount() << " threads" << std::endl;
+
+    // 出生点附近地表上的随机起点, 终点在 16..96 格之外
+    std::mt19937 random(seed);
+    std::uniform_int_distribution<int> offset(-200, 200);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f), distance(16.0f, 96.0f);
+    std::vector<PathRequest> requests;
+    while ((int)requests.size() < requestCount) {
+        int x = worldWidth / 2 + offset(random), z = worldDepth / 2 + offset(random);
+        float a = angle(random), d = distance(random);
+        int gx = x + (int)(std::cos(a) * d), gz = z + (int)(std::sin(a) * d);
+        if (!grid.isInsideWorld(gx, 0, gz)) continue;
+        requests.push_back({ glm::ivec3(x, surfaceHeight(grid, x, z) + 1, z), glm::ivec3(gx, surfaceHeight(grid, gx, gz) + 1, gz) });
+    }
+
+    std::vector<PathResult> results;
+    paths.findPaths(requests, results);
+    long long found = 0, cells = 0, regions = 0, length = 0;
+    for (const PathResult& result : results) {
+        if (!result.found) continue;
+        found++;
+        cells += result.cellsExpanded;
+        regions += result.regionsExpanded;
+        length += result.path.size();
+    }
+    std::cout << "[INFO] Hierarchical: " << requestCount << " requests in " << paths.lastBatchMs << " ms ("
+              << requestCount / (paths.lastBatchMs / 1000.0) << " paths/s), " << found << " found; avg "
+              << (double)regions / std::max(1LL, found) << " regions and " << (double)cells / std::max(1LL, found) << " cells expanded, path "
+              << (double)length / std::max(1LL, found) << " cells" << std::endl;
+
+    // 单线程下与直接在格子上做 A* 对比 (取前一部分请求)
+    int compareCount = std::min(requestCount, 500);
+    double hierarchicalMs = 0.0, directMs = 0.0;
+    long long directCells = 0, hierarchicalLength = 0, directLength = 0, bothFound = 0, mismatched = 0;
+    for (int i = 0; i < compareCount; ++i) {
+        Clock::time_point start = Clock::now();
+        PathResult hierarchical = paths.findPath(requests[i]);
+        hierarchicalMs += elapsedMs(start);
+        start = Clock::now();
+        PathResult direct = paths.findPathDirect(requests[i]);
+        directMs += elapsedMs(start);
+        directCells += direct.cellsExpanded;
+        if (hierarchical.found != direct.found) mismatched++;
+        if (hierarchical.found && direct.found) {
+            bothFound++;
+            hierarchicalLength += hierarchical.path.size();
+            directLength += direct.path.size();
+        }
+    }
+    std::cout << "[INFO] Single thread, " << compareCount << " requests: hierarchical " << compareCount / (hierarchicalMs / 1000.0)
+              << " paths/s, direct A* " << compareCount / (directMs / 1000.0) << " paths/s (avg " << (double)directCells / compareCount
+              << " cells expanded); hierarchical paths " << (double)hierarchicalLength / std::max(1LL, directLength) * 100.0 - 100.0
+              << "% longer; " << mismatched << " requests found by only one of them" << std::endl;
+
+    // 增量更新: 每次修改一个方块后重建受影响的区块
+    std::uniform_int_distribution<int> column(0, worldWidth - 1);
+    double refreshMs = 0.0;
+    long long rebuilt = 0;
+    const int editCount = 100;
+    for (int i = 0; i < editCount; ++i) {
+        int x = column(random), z = column(random) % worldDepth;
+        int y = surfaceHeight(grid, x, z);
+        grid.setBlock(x, y, z, BlockType::BLOCK_AIR);
+        paths.invalidate(x, z);
+        paths.refresh(allReady);
+        refreshMs += paths.lastRefreshMs;
+        rebuilt += paths.lastRebuiltChunks;
+    }
+    std::cout << "[INFO] Invalidation: " << editCount << " edits, avg " << (double)rebuilt / editCount << " chunks rebuilt and "
+              << refreshMs / editCount << " ms per edit" << std::endl;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    std::string command = argc > 1 ? argv[1] : "";
+    if (command == "pregen" && argc >= 3) {
+        float radius = argc > 3 ? (float)std::atof(argv[3]) : 1e9f;
+        int threads = argc > 4 ? std::atoi(argv[4]) : 0;
+        return pregen(std::atoi(argv[2]), radius, threads);
+    }
+    if (command == "load" && argc >= 3) {
+        int threads = argc > 3 ? std::atoi(argv[3]) : 0;
+        return load(std::atoi(argv[2]), threads);
+    }
+    if (command == "verify-determinism" && argc >= 3) {
+        return verifyDeterminism(std::atoi(argv[2]));
+    }
+    if (command == "verify-smoothing") {
+        std::vector<int> seeds;
+        for (int i = 2; i < argc; ++i) seeds.push_back(std::atoi(argv[i]));
+        if (seeds.empty()) seeds = { 1, 12345, -7, 99999 };
+        return verifySmoothing(seeds);
+    }
+    if (command == "bench-region" && argc >= 3) {
+        int threads = argc > 3 ? std::atoi(argv[3]) : 0;
+        return benchRegion(std::atoi(argv[2]), threads);
+    }
+    if (command == "bench-io" && argc >= 3) {
+        int threads = argc > 3 ? std::atoi(argv[3]) : 0;
+        int batchSize = argc > 4 ? std::max(1, std::atoi(argv[4])) : 64;
+        return benchIO(std::atoi(argv[2]), threads, batchSize);
+    }
+    if (command == "bench-ray" && argc >= 3) {
+        int rayCount = argc > 3 ? std::max(1, std::atoi(argv[3])) : 100000;
+        return benchRay(std::atoi(argv[2]), rayCount);
+    }
+    if (command == "bench-entities" && argc >= 3) {
+        int entityCount = argc > 3 ? std::max(1, std::atoi(argv[3])) : 1000;
+        return benchEntities(std::atoi(argv[2]), entityCount);
+    }
+    if (command == "bench-path" && argc >= 3) {
+        int requestCount = argc > 3 ? std::atoi(argv[3]) : 2000;
+        int threads = argc > 4 ? std::atoi(argv[4]) : 0;
+        return benchPath(std::atoi(argv[2]), requestCount, threads);
+    }
+    if (command == "bench-light" && argc >= 3) {
+        int editCount = argc > 3 ? std::atoi(argv[3]) : 2000;
+        return benchLight(std::atoi(argv[2]), editCount);
+    }
+    if (command == "bench-density" && argc >= 3) {
+        return benchDensity(std::atoi(argv[2]));
+    }
+    if (command == "bench-fluid" && argc >= 3) {
+        int threads = argc > 3 ? std::atoi(argv[3]) : 0;
+        return benchFluid(std::atoi(argv[2]), threads);
+    }
+    std::cerr << "Usage:" << std::endl
+              << "  worldtool pregen <seed> [radius in chunks] [threads]" << std::endl
+              << "  worldtool load <seed> [threads]" << std::endl
+              << "  worldtool verify-determinism <seed>" << std::endl
+              << "  worldtool verify-smoothing [seeds...]" << std::endl
+              << "  worldtool bench-region <seed> [threads]" << std::endl
+              << "  worldtool bench-io <seed> [threads] [chunks per batch]" << std::endl
+              << "  worldtool bench-ray <seed> [rays per set]" << std::endl
+              << "  worldtool bench-entities <seed> [entities]" << std::endl
+              << "  worldtool bench-density <seed>" << std::endl
+              << "  worldtool bench-fluid <seed> [threads]" << std::endl
+              << "  worldtool bench-light <seed> [edits]" << std::endl
+              << "  worldtool bench-path <seed> [requests] [threads]" << std::endl;
+    return 1;
+}